@@ -0,0 +1,139 @@
+#include "exprtmpl.h"
+
+#include <chrono>
+#include <cstdio>
+#include <valarray>
+
+using namespace stl;
+
+// Compares stl::Array expressions with hand-written loops and std::valarray
+// for array sizes from L1-resident to DRAM-resident, reporting the memory
+// bandwidth and floating point rate each reaches.
+
+using Clock = std::chrono::steady_clock;
+
+volatile double sink;  // keeps reductions from being optimized away
+
+// tell the compiler that memory may have been read and written, so that
+// repeated calls of a kernel are neither merged nor hoisted out of the loop
+inline void clobber_memory() { asm volatile("" : : : "memory"); }
+
+// best time in seconds per call of `f`, out of five trials of `reps` calls
+template <typename F>
+double time_per_call(size_t reps, F&& f) {
+  double best = 1e300;
+  for (int trial = 0; trial < 5; trial++) {
+    auto start = Clock::now();
+    for (size_t r = 0; r < reps; r++) {
+      f();
+      clobber_memory();
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    best = std::min(best, elapsed.count() / reps);
+  }
+  return best;
+}
+
+// print one result; `bytes` and `flops` are per element
+void report(const char* kernel, const char* impl, size_t n, double seconds,
+            double bytes, double flops) {
+  std::printf("%-6s %-9s %10zu %9.1f KiB %9.2f GB/s %9.2f GFLOP/s\n", kernel,
+              impl, n, n * bytes / 1024, n * bytes / seconds / 1e9,
+              n * flops / seconds / 1e9);
+}
+
+void run(size_t n) {
+  // enough calls per trial to take a measurable time at every size
+  size_t reps = std::max<size_t>(1, (size_t(1) << 26) / n);
+
+  Array<double> x(n), y(n), z(n);
+  std::valarray<double> vx(n), vy(n), vz(n);
+  for (size_t i = 0; i < n; i++) {
+    x[i] = vx[i] = 1.0 + (i % 7) * 0.125;
+    y[i] = vy[i] = 2.0 - (i % 5) * 0.25;
+  }
+  double* px = x.rep().data();
+  double* py = y.rep().data();
+  double* pz = z.rep().data();
+  const double a = 1e-9, s = 0.5;
+  const double c0 = 1.0, c1 = -0.5, c2 = 0.25, c3 = -0.125;
+
+  // axpy: y = a * x + y (read x and y, write y)
+  report("axpy", "Array", n, time_per_call(reps, [&] { y = a * x + y; }), 24,
+         2);
+  report("axpy", "loop", n, time_per_call(reps, [&] {
+           for (size_t i = 0; i < n; i++) {
+             py[i] = a * px[i] + py[i];
+           }
+         }),
+         24, 2);
+  report("axpy", "valarray", n,
+         time_per_call(reps, [&] { vy = a * vx + vy; }), 24, 2);
+
+  // triad: z = x + s * y (read x and y, write z)
+  report("triad", "Array", n, time_per_call(reps, [&] { z = x + s * y; }), 24,
+         2);
+  report("triad", "loop", n, time_per_call(reps, [&] {
+           for (size_t i = 0; i < n; i++) {
+             pz[i] = px[i] + s * py[i];
+           }
+         }),
+         24, 2);
+  report("triad", "valarray", n,
+         time_per_call(reps, [&] { vz = vx + s * vy; }), 24, 2);
+
+  // scale: z = s * x (read x, write z). The result is written once and not
+  // read again: above the last-level cache size the Array assignment uses
+  // streaming stores, while the loop's stores first read each line of z
+  report("scale", "Array", n, time_per_call(reps, [&] { z = s * x; }), 16, 1);
+  report("scale", "loop", n, time_per_call(reps, [&] {
+           for (size_t i = 0; i < n; i++) {
+             pz[i] = s * px[i];
+           }
+         }),
+         16, 1);
+  report("scale", "valarray", n, time_per_call(reps, [&] { vz = s * vx; }),
+         16, 1);
+
+  // poly: z = c3 x^3 + c2 x^2 + c1 x + c0 by Horner's rule (read x, write z)
+  report("poly", "Array", n, time_per_call(reps, [&] {
+           z = ((x * c3 + c2) * x + c1) * x + c0;
+         }),
+         16, 6);
+  report("poly", "loop", n, time_per_call(reps, [&] {
+           for (size_t i = 0; i < n; i++) {
+             pz[i] = ((px[i] * c3 + c2) * px[i] + c1) * px[i] + c0;
+           }
+         }),
+         16, 6);
+  report("poly", "valarray", n, time_per_call(reps, [&] {
+           vz = ((vx * c3 + c2) * vx + c1) * vx + c0;
+         }),
+         16, 6);
+
+  // dot: sum of x * y (read x and y)
+  report("dot", "Array", n, time_per_call(reps, [&] { sink = sum(x * y); }),
+         16, 2);
+  report("dot", "loop", n, time_per_call(reps, [&] {
+           double acc = 0;
+           for (size_t i = 0; i < n; i++) {
+             acc += px[i] * py[i];
+           }
+           sink = acc;
+         }),
+         16, 2);
+  report("dot", "valarray", n,
+         time_per_call(reps, [&] { sink = (vx * vy).sum(); }), 16, 2);
+}
+
+int main(int argc, char* argv[]) {
+  // from 4 KiB (L1) to 128 MiB (DRAM) per array unless a maximum number of
+  // elements is given
+  size_t max_n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1 << 24;
+  std::printf("%-6s %-9s %10s %13s %14s %17s\n", "kernel", "impl", "n",
+              "working set", "bandwidth", "compute");
+  for (size_t n = 1 << 9; n <= max_n; n <<= 3) {
+    run(n);
+  }
+  return 0;
+}
@@ -0,0 +1,34 @@
+#include <utility>
+
+#include "tuple.h"
+
+using namespace stl;
+
+// Compile-time benchmark: instantiates a tuple of TUPLE_SIZE distinct element
+// types, like a wide generated record, and accesses, copies and compares all
+// of its elements. Build with -DTUPLE_SIZE=<n> and time the compilation
+// (`make tuple_compile_bench` does this for 50 and 200 elements).
+
+#ifndef TUPLE_SIZE
+#define TUPLE_SIZE 50
+#endif
+
+template <size_t I>
+struct field {
+  int value;
+
+  bool operator==(const field&) const = default;
+};
+
+template <size_t... I>
+int touch_all(std::index_sequence<I...>) {
+  tuple<field<I>...> record(field<I>{static_cast<int>(I)}...);
+  tuple<field<I>...> copy(record);
+  int total = (get<I>(record).value + ...);
+  return record == copy ? total : -1;
+}
+
+int main() {
+  int total = touch_all(std::make_index_sequence<TUPLE_SIZE>());
+  return total == TUPLE_SIZE * (TUPLE_SIZE - 1) / 2 ? 0 : 1;
+}
@@ -1,7 +1,32 @@
 #ifndef EXPRTMPL_H_
 #define EXPRTMPL_H_
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
 #include <cassert>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <numbers>
+#include <optional>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "array.h"
+#include "type_traits.h"
 
 /*============================================================
 ======================Expression Templates====================
@@ -9,6 +34,109 @@
 
 namespace stl {
 
+/*==================Reduced-precision storage=================*/
+
+// 16-bit brain floating point (the upper half of an IEEE binary32): the
+// same range as float with 8 bits of precision. Values convert to float
+// for computation, so arrays of bfloat16 halve the memory traffic of float
+// arrays while expressions over them accumulate in float
+struct bfloat16 {
+  constexpr bfloat16() : bits(0){};
+
+  // round to nearest, ties to even; NaNs stay (quiet) NaNs
+  constexpr bfloat16(float f) : bits(0) {
+    uint32_t x = std::bit_cast<uint32_t>(f);
+    if ((x & 0x7FFFFFFF) > 0x7F800000) {
+      bits = static_cast<uint16_t>((x >> 16) | 0x40);
+    } else {
+      bits = static_cast<uint16_t>((x + 0x7FFF + ((x >> 16) & 1)) >> 16);
+    }
+  }
+
+  constexpr operator float() const {
+    return std::bit_cast<float>(static_cast<uint32_t>(bits) << 16);
+  }
+
+  uint16_t bits;
+};
+
+// 16-bit IEEE binary16 floating point: 11 bits of precision, range up to
+// 65504. Like bfloat16 it is a storage type that computes in float
+struct float16 {
+  constexpr float16() : bits(0){};
+
+  // round to nearest, ties to even; overflow gives infinity
+  constexpr float16(float f) : bits(0) {
+    uint32_t x = std::bit_cast<uint32_t>(f);
+    uint32_t sign = (x >> 16) & 0x8000;
+    uint32_t abs = x & 0x7FFFFFFF;
+    if (abs >= 0x7F800000) {
+      // infinity or NaN
+      bits = sign | 0x7C00 | (abs > 0x7F800000 ? 0x200 : 0);
+    } else if (abs >= 0x477FF000) {
+      // 65520 and above round to infinity
+      bits = sign | 0x7C00;
+    } else if (abs < 0x38800000) {
+      // below the smallest normal half: adding 0.5 rounds the value to a
+      // multiple of 2^-24, the spacing of the half subnormals
+      float r = std::bit_cast<float>(abs) + 0.5f;
+      bits = sign | (std::bit_cast<uint32_t>(r) - 0x3F000000);
+    } else {
+      // rebias the exponent from 127 to 15 and round off 13 mantissa bits
+      abs += 0xC8000FFF + ((abs >> 13) & 1);
+      bits = sign | (abs >> 13);
+    }
+  }
+
+  constexpr operator float() const {
+    uint32_t sign = static_cast<uint32_t>(bits & 0x8000) << 16;
+    uint32_t exp = (bits >> 10) & 0x1F;
+    uint32_t mant = bits & 0x3FF;
+    if (exp == 0x1F) {
+      return std::bit_cast<float>(sign | 0x7F800000 | (mant << 13));
+    }
+    if (exp == 0) {
+      // zero or subnormal: mant * 2^-24
+      float f = static_cast<float>(mant) * 0x1p-24f;
+      return std::bit_cast<float>(sign | std::bit_cast<uint32_t>(f));
+    }
+    return std::bit_cast<float>(sign | ((exp + 112) << 23) | (mant << 13));
+  }
+
+  uint16_t bits;
+};
+
+inline std::ostream& operator<<(std::ostream& strm, bfloat16 v) {
+  return strm << static_cast<float>(v);
+}
+
+inline std::ostream& operator<<(std::ostream& strm, float16 v) {
+  return strm << static_cast<float>(v);
+}
+
+// type in which elements stored as T take part in computations
+template <typename T>
+struct A_Compute {
+  using type = T;
+};
+
+template <>
+struct A_Compute<bfloat16> {
+  using type = float;
+};
+
+template <>
+struct A_Compute<float16> {
+  using type = float;
+};
+
+template <typename T>
+using A_Compute_t = typename A_Compute<T>::type;
+
+// element type of an operation on elements of type T1 and T2
+template <typename T1, typename T2>
+using A_Promote_t = common_type_t<A_Compute_t<T1>, A_Compute_t<T2>>;
+
 // storage array
 template <typename T>
 class SArray {
@@ -40,6 +168,10 @@ class SArray {
   const T& operator[](size_t idx) const { return storage[idx]; }
   T& operator[](size_t idx) { return storage[idx]; }
 
+  // direct access to the underlying storage
+  const T* data() const { return storage; }
+  T* data() { return storage; }
+
   void print() const {
     std::cout << "[";
     for (size_t i = 0; i < storage_size - 1; i++) {
@@ -69,45 +201,262 @@ class SArray {
   size_t storage_size;
 };
 
-// forward declaration
+// forward declarations
 template <typename T>
 class A_Scalar;
 
+template <typename T, size_t N>
+class STensor;
+
+template <typename T, size_t N, typename Rep>
+class Tensor;
+
+template <typename T, typename OP1, typename OP2, size_t N>
+class A_MatMul;
+
+// extents of an N-dimensional array in row-major order (the last dimension
+// is the innermost, contiguous one); also used as an N-dimensional index
+template <size_t N>
+struct A_Shape {
+  size_t dims[N == 0 ? 1 : N];
+
+  size_t& operator[](size_t k) { return dims[k]; }
+  size_t operator[](size_t k) const { return dims[k]; }
+
+  // total number of elements
+  size_t count() const {
+    size_t n = 1;
+    for (size_t k = 0; k < N; k++) {
+      n *= dims[k];
+    }
+    return n;
+  }
+
+  bool operator==(const A_Shape&) const = default;
+};
+
+// NumPy-style broadcast of two shapes: shapes are aligned at their innermost
+// dimension, missing leading dimensions count as 1, and each pair of extents
+// must either match or contain a 1
+template <size_t N1, size_t N2>
+auto broadcast_shape(const A_Shape<N1>& a, const A_Shape<N2>& b) {
+  constexpr size_t N = N1 > N2 ? N1 : N2;
+  A_Shape<N> result;
+  for (size_t k = 0; k < N; k++) {
+    size_t ea = k + N1 >= N ? a[k + N1 - N] : 1;
+    size_t eb = k + N2 >= N ? b[k + N2 - N] : 1;
+    assert(ea == eb || ea == 1 || eb == 1);
+    result[k] = ea == 1 ? eb : ea;
+  }
+  return result;
+}
+
 // helper class traits template to select whether to refer to
-// an expression template node either by value or by reference
+// an expression template node either by value or by reference:
+// expression nodes and scalars are small and are copied, so that an
+// expression built from temporaries stays valid beyond the full-expression;
+// only storage (which owns the data) is referred to by reference
 template <typename T>
 struct A_Traits {
-  using ExprRef = const T&;
+  using ExprRef = T;
 };
 
 template <typename T>
-struct A_Traits<A_Scalar<T>> {
-  using ExprRef = A_Scalar<T>;
+struct A_Traits<SArray<T>> {
+  using ExprRef = const SArray<T>&;
+};
+
+template <typename T, size_t N>
+struct A_Traits<STensor<T, N>> {
+  using ExprRef = const STensor<T, N>&;
+};
+
+template <typename T, size_t N>
+struct A_Traits<array<T, N>> {
+  using ExprRef = const array<T, N>&;
+};
+
+// number of elements of expression E when it is known at compile time
+// (storage of a fixed size, and nodes over it), 0 otherwise
+template <typename E>
+struct A_StaticSize : integral_constant<size_t, 0> {};
+
+template <typename T, size_t N>
+struct A_StaticSize<array<T, N>> : integral_constant<size_t, N> {};
+
+// compile-time size of a node with operands E...: operands of a fixed size
+// must agree, and scalars and runtime-sized operands adopt it
+template <typename... E>
+struct A_StaticSizeOf
+    : integral_constant<size_t,
+                        std::max({size_t(0), A_StaticSize<E>::value...})> {
+  static_assert(((A_StaticSize<E>::value == 0 ||
+                  A_StaticSize<E>::value == A_StaticSizeOf::value) &&
+                 ...),
+                "operands have different sizes");
+};
+
+// whether expression E is sparse: it can enumerate its nonzero elements
+// through a cursor, an object with
+//   bool valid() const;    // not yet past the last nonzero
+//   size_t index() const;  // index of the current nonzero
+//   T value() const;       // its value
+//   void next();           // advance to the next nonzero
+// that visits the nonzeros in increasing index order. A product is sparse if
+// either operand is, and a sum if both are
+template <typename E>
+struct A_IsSparse : false_type {};
+
+// cursor over the nonzeros of a sparse operand multiplied by the elements of
+// a dense (or scalar) operand at the same indices
+template <typename T, typename C, typename D>
+class A_ScaleCursor {
+ public:
+  A_ScaleCursor(const C& c, const D& d) : cursor(c), dense(d){};
+
+  bool valid() const { return cursor.valid(); }
+  size_t index() const { return cursor.index(); }
+  T value() const {
+    return static_cast<T>(cursor.value()) *
+           static_cast<T>(dense[cursor.index()]);
+  }
+  void next() { cursor.next(); }
+
+ private:
+  C cursor;
+  typename A_Traits<D>::ExprRef dense;
+};
+
+// cursor over the product of two sparse operands: a merge-join that visits
+// only the indices at which both have a nonzero
+template <typename T, typename C1, typename C2>
+class A_IntersectCursor {
+ public:
+  A_IntersectCursor(const C1& a, const C2& b) : c1(a), c2(b) { align(); }
+
+  bool valid() const { return c1.valid() && c2.valid(); }
+  size_t index() const { return c1.index(); }
+  T value() const {
+    return static_cast<T>(c1.value()) * static_cast<T>(c2.value());
+  }
+  void next() {
+    c1.next();
+    c2.next();
+    align();
+  }
+
+ private:
+  // advance the cursor that is behind until both are at the same index
+  void align() {
+    while (c1.valid() && c2.valid() && c1.index() != c2.index()) {
+      if (c1.index() < c2.index()) {
+        c1.next();
+      } else {
+        c2.next();
+      }
+    }
+  }
+
+  C1 c1;
+  C2 c2;
+};
+
+// cursor over the sum of two sparse operands: a merge-join that visits the
+// indices at which either has a nonzero
+template <typename T, typename C1, typename C2>
+class A_UnionCursor {
+ public:
+  A_UnionCursor(const C1& a, const C2& b) : c1(a), c2(b) { update(); }
+
+  bool valid() const { return c1.valid() || c2.valid(); }
+  size_t index() const { return idx; }
+  T value() const {
+    T v = T();
+    if (at1) {
+      v += static_cast<T>(c1.value());
+    }
+    if (at2) {
+      v += static_cast<T>(c2.value());
+    }
+    return v;
+  }
+  void next() {
+    if (at1) {
+      c1.next();
+    }
+    if (at2) {
+      c2.next();
+    }
+    update();
+  }
+
+ private:
+  // the current index is the smaller of the two operands' indices
+  void update() {
+    at1 = c1.valid() && (!c2.valid() || c1.index() <= c2.index());
+    at2 = c2.valid() && (!c1.valid() || c2.index() <= c1.index());
+    idx = at1 ? c1.index() : at2 ? c2.index() : 0;
+  }
+
+  C1 c1;
+  C2 c2;
+  size_t idx;
+  bool at1;  // c1 is at the current index
+  bool at2;  // c2 is at the current index
 };
 
 // class for objects that represent the addition of two operands
 template <typename T, typename OP1, typename OP2>
 class A_Add {
  public:
-  // constructor initializes references to operands
+  // constructor initializes (references to) operands
   A_Add(const OP1& a, const OP2& b) : op1(a), op2(b){};
 
-  // compute sum when value requested
-  T operator[](size_t idx) const { return op1[idx] + op2[idx]; }
+  // compute sum when value requested; operands are converted to the
+  // (promoted) element type first
+  T operator[](size_t idx) const {
+    return static_cast<T>(op1[idx]) + static_cast<T>(op2[idx]);
+  }
 
-  // size is maximum size
+  // size is maximum size (a constant for operands of a fixed size)
   size_t size() const {
     assert(op1.size() == 0 || op2.size() == 0 || op1.size() == op2.size());
-    return op1.size() != 0 ? op1.size() : op2.size();
+    if constexpr (A_StaticSizeOf<OP1, OP2>::value != 0) {
+      return A_StaticSizeOf<OP1, OP2>::value;
+    } else {
+      return op1.size() != 0 ? op1.size() : op2.size();
+    }
   }
 
   void print() const {
     std::cout << "[";
     size_t n = size();
     for (size_t i = 0; i < n - 1; i++) {
-      std::cout << op1[i] + op2[i] << ", ";
+      std::cout << (*this)[i] << ", ";
     }
-    std::cout << op1[n - 1] + op2[n - 1] << "]\n";
+    std::cout << (*this)[n - 1] << "]\n";
+  }
+
+  // shape of N-dimensional operands is the broadcast of their shapes
+  auto shape() const { return broadcast_shape(op1.shape(), op2.shape()); }
+
+  // innermost row at the (outer) index `idx` as a one-dimensional expression
+  template <size_t N>
+  auto row(const A_Shape<N>& idx) const {
+    using R1 = decltype(op1.row(idx));
+    using R2 = decltype(op2.row(idx));
+    return A_Add<T, R1, R2>(op1.row(idx), op2.row(idx));
+  }
+
+  // operands, for rewriting the expression (see optimize())
+  const auto& lhs() const { return op1; }
+  const auto& rhs() const { return op2; }
+
+  // nonzeros of the sum of two sparse operands (see A_IsSparse)
+  auto cursor() const {
+    using C1 = decltype(op1.cursor());
+    using C2 = decltype(op2.cursor());
+    return A_UnionCursor<T, C1, C2>(op1.cursor(), op2.cursor());
   }
 
  private:
@@ -119,30 +468,138 @@ class A_Add {
 template <typename T, typename OP1, typename OP2>
 class A_Mult {
  public:
-  // constructor initializes references to operands
+  // constructor initializes (references to) operands
   A_Mult(const OP1& a, const OP2& b) : op1(a), op2(b){};
 
-  // compute product when value requested
-  T operator[](size_t idx) const { return op1[idx] * op2[idx]; }
+  // compute product when value requested; operands are converted to the
+  // (promoted) element type first
+  T operator[](size_t idx) const {
+    return static_cast<T>(op1[idx]) * static_cast<T>(op2[idx]);
+  }
 
-  // size is maximum size
+  // size is maximum size (a constant for operands of a fixed size)
   size_t size() const {
     assert(op1.size() == 0 || op2.size() == 0 || op1.size() == op2.size());
-    return op1.size() != 0 ? op1.size() : op2.size();
+    if constexpr (A_StaticSizeOf<OP1, OP2>::value != 0) {
+      return A_StaticSizeOf<OP1, OP2>::value;
+    } else {
+      return op1.size() != 0 ? op1.size() : op2.size();
+    }
+  }
+
+  void print() const {
+    std::cout << "[";
+    size_t n = size();
+    for (size_t i = 0; i < n - 1; i++) {
+      std::cout << (*this)[i] << ", ";
+    }
+    std::cout << (*this)[n - 1] << "]\n";
+  }
+
+  // shape of N-dimensional operands is the broadcast of their shapes
+  auto shape() const { return broadcast_shape(op1.shape(), op2.shape()); }
+
+  // innermost row at the (outer) index `idx` as a one-dimensional expression
+  template <size_t N>
+  auto row(const A_Shape<N>& idx) const {
+    using R1 = decltype(op1.row(idx));
+    using R2 = decltype(op2.row(idx));
+    return A_Mult<T, R1, R2>(op1.row(idx), op2.row(idx));
+  }
+
+  // operands, for rewriting the expression (see optimize())
+  const auto& lhs() const { return op1; }
+  const auto& rhs() const { return op2; }
+
+  // nonzeros of the product of a sparse operand (see A_IsSparse)
+  auto cursor() const {
+    if constexpr (A_IsSparse<OP1>::value && A_IsSparse<OP2>::value) {
+      using C1 = decltype(op1.cursor());
+      using C2 = decltype(op2.cursor());
+      return A_IntersectCursor<T, C1, C2>(op1.cursor(), op2.cursor());
+    } else if constexpr (A_IsSparse<OP1>::value) {
+      using C1 = decltype(op1.cursor());
+      return A_ScaleCursor<T, C1, OP2>(op1.cursor(), op2);
+    } else {
+      using C2 = decltype(op2.cursor());
+      return A_ScaleCursor<T, C2, OP1>(op2.cursor(), op1);
+    }
+  }
+
+ private:
+  typename A_Traits<OP1>::ExprRef op1;
+  typename A_Traits<OP2>::ExprRef op2;
+};
+
+// a * b + c, with a single rounding where the target has a fast fused
+// multiply-add instruction
+template <typename T>
+constexpr T A_fma(const T& a, const T& b, const T& c) {
+#if defined(FP_FAST_FMA) && defined(FP_FAST_FMAF)
+  if constexpr (is_floating_point_v<T>) {
+    return std::fma(a, b, c);
+  }
+#endif
+  return a * b + c;
+}
+
+// class for objects that represent the fused multiply-add of three operands;
+// created by optimize() from an addition with a product operand
+template <typename T, typename OP1, typename OP2, typename OP3>
+class A_FMA {
+ public:
+  // constructor initializes (references to) operands
+  A_FMA(const OP1& a, const OP2& b, const OP3& c) : op1(a), op2(b), op3(c){};
+
+  // compute op1 * op2 + op3 when value requested
+  T operator[](size_t idx) const {
+    return A_fma<T>(op1[idx], op2[idx], op3[idx]);
+  }
+
+  // size is maximum size (a constant for operands of a fixed size)
+  size_t size() const {
+    size_t n = std::max({op1.size(), op2.size(), op3.size()});
+    assert(op1.size() == 0 || op1.size() == n);
+    assert(op2.size() == 0 || op2.size() == n);
+    assert(op3.size() == 0 || op3.size() == n);
+    if constexpr (A_StaticSizeOf<OP1, OP2, OP3>::value != 0) {
+      return A_StaticSizeOf<OP1, OP2, OP3>::value;
+    } else {
+      return n;
+    }
   }
 
   void print() const {
     std::cout << "[";
     size_t n = size();
     for (size_t i = 0; i < n - 1; i++) {
-      std::cout << op1[i] * op2[i] << ", ";
+      std::cout << (*this)[i] << ", ";
     }
-    std::cout << op1[n - 1] * op2[n - 1] << "]\n";
+    std::cout << (*this)[n - 1] << "]\n";
+  }
+
+  auto shape() const {
+    return broadcast_shape(broadcast_shape(op1.shape(), op2.shape()),
+                           op3.shape());
+  }
+
+  template <size_t N>
+  auto row(const A_Shape<N>& idx) const {
+    using R1 = decltype(op1.row(idx));
+    using R2 = decltype(op2.row(idx));
+    using R3 = decltype(op3.row(idx));
+    return A_FMA<T, R1, R2, R3>(op1.row(idx), op2.row(idx), op3.row(idx));
   }
 
+  // operands, for inspecting the expression
+  const auto& factor1() const { return op1; }
+  const auto& factor2() const { return op2; }
+  const auto& addend() const { return op3; }
+
  private:
   typename A_Traits<OP1>::ExprRef op1;
   typename A_Traits<OP2>::ExprRef op2;
+  typename A_Traits<OP3>::ExprRef op3;
 };
 
 // class for objects that represent scalars
@@ -153,107 +610,1998 @@ class A_Scalar {
   constexpr A_Scalar(const T& v) : s(v){};
 
   // for index operations, the scalar is the value of each element
-  constexpr const T& operator[]([[maybe_unused]] size_t idx) const { return s; }
+  constexpr T operator[]([[maybe_unused]] size_t idx) const { return s; }
 
   // scalars have zero as size
   constexpr size_t size() const { return 0; }
 
   void print() const { std::cout << s << '\n'; }
 
+  constexpr T value() const { return s; }
+
+  // scalars have rank zero and broadcast into every row
+  A_Shape<0> shape() const { return {}; }
+
+  template <size_t N>
+  const A_Scalar& row([[maybe_unused]] const A_Shape<N>& idx) const {
+    return *this;
+  }
+
  private:
-  const T& s;
+  T s;  // held by value: the scalar is usually a temporary
 };
 
-template <typename T, typename Rep = SArray<T>>
-class Array {
+// class for objects that represent the elementwise comparison of two
+// operands; elements are bool, so the node acts as a lazy mask (e.g. as the
+// condition of a select node). Cmp compares two values of the (promoted)
+// type T, as std::less<T> does
+template <typename T, typename OP1, typename OP2, typename Cmp>
+class A_Compare {
  public:
-  // create array with initial size
-  explicit Array(size_t s) : expr_rep(s){};
+  // constructor initializes (references to) operands
+  A_Compare(const OP1& a, const OP2& b) : op1(a), op2(b){};
 
-  // create array from possible implementation
-  Array(const Rep& rb) : expr_rep(rb){};
+  // compare elements when value requested
+  bool operator[](size_t idx) const {
+    return Cmp()(static_cast<T>(op1[idx]), static_cast<T>(op2[idx]));
+  }
 
-  // assignment operator for same type
-  Array& operator=(const Array& b) {
-    assert(size() == b.size());
-    for (size_t idx = 0; idx < b.size(); idx++) {
-      expr_rep[idx] = b[idx];
+  // size is maximum size (a constant for operands of a fixed size)
+  size_t size() const {
+    assert(op1.size() == 0 || op2.size() == 0 || op1.size() == op2.size());
+    if constexpr (A_StaticSizeOf<OP1, OP2>::value != 0) {
+      return A_StaticSizeOf<OP1, OP2>::value;
+    } else {
+      return op1.size() != 0 ? op1.size() : op2.size();
     }
-    return *this;
   }
 
-  // assignment operator for arrays of different type
-  template <typename T2, typename Rep2>
-  Array& operator=(const Array<T2, Rep2>& b) {
-    assert(size() == b.size());
-    for (size_t idx = 0; idx < b.size(); idx++) {
-      expr_rep[idx] = b[idx];
+  void print() const {
+    std::cout << "[";
+    size_t n = size();
+    for (size_t i = 0; i < n - 1; i++) {
+      std::cout << (*this)[i] << ", ";
     }
-    return *this;
+    std::cout << (*this)[n - 1] << "]\n";
   }
 
-  // size is size of represented data
-  size_t size() const { return expr_rep.size(); }
+  // operands, for rewriting the expression (see optimize())
+  const auto& lhs() const { return op1; }
+  const auto& rhs() const { return op2; }
 
-  // index operator for constants and variables
-  decltype(auto) operator[](size_t idx) const {
-    assert(idx < size());
-    return expr_rep[idx];
-  }
-  T& operator[](size_t idx) {
-    assert(idx < size());
-    return expr_rep[idx];
+ private:
+  typename A_Traits<OP1>::ExprRef op1;
+  typename A_Traits<OP2>::ExprRef op2;
+};
+
+// class for objects that represent the elementwise choice between two
+// operands: element idx is op1[idx] where cond[idx] holds and op2[idx]
+// elsewhere
+template <typename T, typename C, typename OP1, typename OP2>
+class A_Select {
+ public:
+  // constructor initializes (references to) condition and operands
+  A_Select(const C& c, const OP1& a, const OP2& b)
+      : cond(c), op1(a), op2(b){};
+
+  // both operands are evaluated before choosing, so that the choice is a
+  // conditional move (a blend in a vectorized loop) rather than a branch
+  // that mispredicts on irregular masks
+  T operator[](size_t idx) const {
+    T a = static_cast<T>(op1[idx]);
+    T b = static_cast<T>(op2[idx]);
+    return cond[idx] ? a : b;
   }
 
-  // return what the array currently represents
-  const Rep& rep() const { return expr_rep; }
+  // size is maximum size (a constant for operands of a fixed size)
+  size_t size() const {
+    size_t n = std::max({cond.size(), op1.size(), op2.size()});
+    assert(cond.size() == 0 || cond.size() == n);
+    assert(op1.size() == 0 || op1.size() == n);
+    assert(op2.size() == 0 || op2.size() == n);
+    if constexpr (A_StaticSizeOf<C, OP1, OP2>::value != 0) {
+      return A_StaticSizeOf<C, OP1, OP2>::value;
+    } else {
+      return n;
+    }
+  }
 
-  Rep& rep() { return expr_rep; }
+  void print() const {
+    std::cout << "[";
+    size_t n = size();
+    for (size_t i = 0; i < n - 1; i++) {
+      std::cout << (*this)[i] << ", ";
+    }
+    std::cout << (*this)[n - 1] << "]\n";
+  }
 
-  void print() const { expr_rep.print(); }
+  // condition and operands, for rewriting the expression (see optimize())
+  const auto& condition() const { return cond; }
+  const auto& lhs() const { return op1; }
+  const auto& rhs() const { return op2; }
 
  private:
-  Rep expr_rep;  // (access to) the data of the array
+  typename A_Traits<C>::ExprRef cond;
+  typename A_Traits<OP1>::ExprRef op1;
+  typename A_Traits<OP2>::ExprRef op2;
 };
 
-// addition of two Arrays
-template <typename T, typename R1, typename R2>
-auto operator+(const Array<T, R1>& a, const Array<T, R2>& b) {
-  return Array<T, A_Add<T, R1, R2>>(A_Add<T, R1, R2>(a.rep(), b.rep()));
+template <typename T, typename OP1, typename OP2>
+struct A_StaticSize<A_Add<T, OP1, OP2>> : A_StaticSizeOf<OP1, OP2> {};
+
+template <typename T, typename OP1, typename OP2>
+struct A_StaticSize<A_Mult<T, OP1, OP2>> : A_StaticSizeOf<OP1, OP2> {};
+
+template <typename T, typename OP1, typename OP2, typename OP3>
+struct A_StaticSize<A_FMA<T, OP1, OP2, OP3>>
+    : A_StaticSizeOf<OP1, OP2, OP3> {};
+
+template <typename T, typename OP1, typename OP2, typename Cmp>
+struct A_StaticSize<A_Compare<T, OP1, OP2, Cmp>> : A_StaticSizeOf<OP1, OP2> {};
+
+template <typename T, typename C, typename OP1, typename OP2>
+struct A_StaticSize<A_Select<T, C, OP1, OP2>> : A_StaticSizeOf<C, OP1, OP2> {};
+
+/*====================Expression rewriting====================*/
+
+// node classification for the rewrite rules; a rule only combines nodes
+// that compute in the same element type T, so that rewriting never changes
+// the precision an operation is carried out in
+template <typename T, typename E>
+struct A_IsScalar : false_type {};
+
+template <typename T>
+struct A_IsScalar<T, A_Scalar<T>> : true_type {};
+
+template <typename T, typename E>
+struct A_IsMult : false_type {};
+
+template <typename T, typename OP1, typename OP2>
+struct A_IsMult<T, A_Mult<T, OP1, OP2>> : true_type {};
+
+// E is `X op scalar` with the scalar already moved to the right
+template <typename T, typename E>
+struct A_HasScalarRhs : false_type {};
+
+template <typename T, typename OP1>
+struct A_HasScalarRhs<T, A_Add<T, OP1, A_Scalar<T>>> : true_type {};
+
+template <typename T, typename OP1>
+struct A_HasScalarRhs<T, A_Mult<T, OP1, A_Scalar<T>>> : true_type {};
+
+// whether (x op s1) op s2 may be evaluated as x op (s1 op s2): always exact
+// for integers, and allowed for floating point under -ffast-math
+template <typename T>
+inline constexpr bool A_Reassociate =
+#ifdef __FAST_MATH__
+    true;
+#else
+    is_integral_v<T>;
+#endif
+
+// rewritten form of the sum of the (already rewritten) operands `l` and `r`
+template <typename T, typename L, typename R>
+auto A_rewrite_add(const L& l, const R& r) {
+  if constexpr (A_IsScalar<T, L>::value && A_IsScalar<T, R>::value) {
+    return A_Scalar<T>(l.value() + r.value());
+  } else if constexpr (A_IsScalar<T, L>::value) {
+    // addition commutes: keep scalars on the right
+    return A_rewrite_add<T>(r, l);
+  } else if constexpr (A_IsMult<T, L>::value) {
+    return A_FMA<T, remove_cvref_t<decltype(l.lhs())>,
+                 remove_cvref_t<decltype(l.rhs())>, R>(l.lhs(), l.rhs(), r);
+  } else if constexpr (A_IsMult<T, R>::value) {
+    return A_FMA<T, remove_cvref_t<decltype(r.lhs())>,
+                 remove_cvref_t<decltype(r.rhs())>, L>(r.lhs(), r.rhs(), l);
+  } else if constexpr (A_IsScalar<T, R>::value && A_HasScalarRhs<T, L>::value &&
+                       A_Reassociate<T>) {
+    // (x + s1) + s2 -> x + (s1 + s2)
+    return A_rewrite_add<T>(l.lhs(), A_Scalar<T>(l.rhs().value() + r.value()));
+  } else {
+    return A_Add<T, L, R>(l, r);
+  }
 }
 
-// addition of Array and scalar
-template <typename T, typename R1>
-auto operator+(const Array<T, R1>& a, const T& s) {
-  return Array<T, A_Add<T, R1, A_Scalar<T>>>(
-      A_Add<T, R1, A_Scalar<T>>(a.rep(), A_Scalar<T>(s)));
+// rewritten form of the product of the (already rewritten) operands `l`
+// and `r`
+template <typename T, typename L, typename R>
+auto A_rewrite_mult(const L& l, const R& r) {
+  if constexpr (A_IsScalar<T, L>::value && A_IsScalar<T, R>::value) {
+    return A_Scalar<T>(l.value() * r.value());
+  } else if constexpr (A_IsScalar<T, L>::value) {
+    // multiplication commutes: keep scalars on the right
+    return A_rewrite_mult<T>(r, l);
+  } else if constexpr (A_IsScalar<T, R>::value && A_IsMult<T, L>::value &&
+                       A_HasScalarRhs<T, L>::value && A_Reassociate<T>) {
+    // (x * s1) * s2 -> x * (s1 * s2)
+    return A_rewrite_mult<T>(l.lhs(),
+                             A_Scalar<T>(l.rhs().value() * r.value()));
+  } else {
+    return A_Mult<T, L, R>(l, r);
+  }
 }
 
-// addition of scalar and Array
-template <typename T, typename R2>
-auto operator+(const T& s, const Array<T, R2>& b) {
-  return Array<T, A_Add<T, A_Scalar<T>, R2>>(
-      A_Add<T, A_Scalar<T>, R2>(A_Scalar<T>(s), b.rep()));
+// rewrite an expression tree bottom-up so the evaluation loop does as few
+// operations as possible: scalar subtrees are folded, scalars are moved to
+// the right of commutative operations, and additions of a product become
+// fused multiply-adds. Leaves are returned unchanged (by reference)
+template <typename E>
+const E& optimize(const E& e) {
+  return e;
 }
 
-// multiplication of two Arrays
-template <typename T, typename R1, typename R2>
-auto operator*(const Array<T, R1>& a, const Array<T, R2>& b) {
-  return Array<T, A_Mult<T, R1, R2>>(A_Mult<T, R1, R2>(a.rep(), b.rep()));
+template <typename T, typename OP1, typename OP2>
+auto optimize(const A_Add<T, OP1, OP2>& e) {
+  return A_rewrite_add<T>(optimize(e.lhs()), optimize(e.rhs()));
 }
 
-// multiplication of Array and scalar
-template <typename T, typename R1>
-auto operator*(const Array<T, R1>& a, const T& s) {
-  return Array<T, A_Mult<T, R1, A_Scalar<T>>>(
-      A_Mult<T, R1, A_Scalar<T>>(a.rep(), s));
+template <typename T, typename OP1, typename OP2>
+auto optimize(const A_Mult<T, OP1, OP2>& e) {
+  return A_rewrite_mult<T>(optimize(e.lhs()), optimize(e.rhs()));
 }
 
-// multiplication of scalar and Array
-template <typename T, typename R2>
-auto operator*(const T& s, const Array<T, R2>& b) {
-  return Array<T, A_Mult<T, A_Scalar<T>, R2>>(
-      A_Mult<T, A_Scalar<T>, R2>(s, b.rep()));
+// comparisons and selections are not rewritten themselves, but their
+// operands are
+template <typename T, typename OP1, typename OP2, typename Cmp>
+auto optimize(const A_Compare<T, OP1, OP2, Cmp>& e) {
+  using R1 = remove_cvref_t<decltype(optimize(e.lhs()))>;
+  using R2 = remove_cvref_t<decltype(optimize(e.rhs()))>;
+  return A_Compare<T, R1, R2, Cmp>(optimize(e.lhs()), optimize(e.rhs()));
+}
+
+template <typename T, typename C, typename OP1, typename OP2>
+auto optimize(const A_Select<T, C, OP1, OP2>& e) {
+  using RC = remove_cvref_t<decltype(optimize(e.condition()))>;
+  using R1 = remove_cvref_t<decltype(optimize(e.lhs()))>;
+  using R2 = remove_cvref_t<decltype(optimize(e.rhs()))>;
+  return A_Select<T, RC, R1, R2>(optimize(e.condition()), optimize(e.lhs()),
+                                 optimize(e.rhs()));
+}
+
+// how the elements of a memory-mapped file can be accessed
+enum class MMapMode {
+  ReadOnly,     // elements cannot be modified
+  CopyOnWrite,  // modified pages are private copies; the file is unchanged
+};
+
+// storage backed by a memory-mapped file of elements of type T, so that
+// expressions run over on-disk arrays without first loading them into the
+// heap; pages are read in by the kernel as the evaluation touches them. The
+// mode is part of the type: a read-only mapping has no mutable element
+// access, so assigning into it does not compile instead of faulting
+template <typename T, MMapMode M = MMapMode::ReadOnly>
+class MMapArray {
+ public:
+  using Mode = MMapMode;
+
+  // map the whole file at `path`. Expressions evaluate in index order, so
+  // the mapping is advised as sequential (read-ahead, early reclaim)
+  explicit MMapArray(const char* path) : storage(nullptr), storage_size(0) {
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+      throw std::system_error(errno, std::generic_category(), path);
+    }
+    struct stat st;
+    if (::fstat(fd, &st) < 0) {
+      int err = errno;
+      ::close(fd);
+      throw std::system_error(err, std::generic_category(), path);
+    }
+    storage_size = static_cast<size_t>(st.st_size) / sizeof(T);
+    if (storage_size > 0) {
+      int prot = writable() ? PROT_READ | PROT_WRITE : PROT_READ;
+      void* p = ::mmap(nullptr, bytes(), prot, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED) {
+        int err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::generic_category(), path);
+      }
+      storage = static_cast<T*>(p);
+      advise(MADV_SEQUENTIAL);
+    }
+    // the mapping keeps its own reference to the file
+    ::close(fd);
+  }
+
+  MMapArray(const MMapArray&) = delete;
+  MMapArray& operator=(const MMapArray&) = delete;
+
+  MMapArray(MMapArray&& other)
+      : storage(std::exchange(other.storage, nullptr)),
+        storage_size(std::exchange(other.storage_size, 0)){};
+
+  // destructor: unmap the file
+  ~MMapArray() {
+    if (storage != nullptr) {
+      ::munmap(storage, bytes());
+    }
+  }
+
+  // return size
+  size_t size() const { return storage_size; }
+
+  // index operator for constants and variables; only copy-on-write
+  // mappings can be modified
+  const T& operator[](size_t idx) const { return storage[idx]; }
+  T& operator[](size_t idx) requires(M == Mode::CopyOnWrite) {
+    return storage[idx];
+  }
+
+  const T* data() const { return storage; }
+  T* data() requires(M == Mode::CopyOnWrite) { return storage; }
+
+  static constexpr bool writable() { return M == Mode::CopyOnWrite; }
+
+  // pass an access pattern hint (MADV_SEQUENTIAL, MADV_RANDOM,
+  // MADV_WILLNEED, ...) for the whole mapping to the kernel
+  void advise(int advice) const {
+    if (storage != nullptr) {
+      ::madvise(storage, bytes(), advice);
+    }
+  }
+
+  void print() const {
+    std::cout << "[";
+    for (size_t i = 0; i + 1 < storage_size; i++) {
+      std::cout << storage[i] << ", ";
+    }
+    if (storage_size > 0) {
+      std::cout << storage[storage_size - 1];
+    }
+    std::cout << "]\n";
+  }
+
+ private:
+  size_t bytes() const { return storage_size * sizeof(T); }
+
+  T* storage;
+  size_t storage_size;
+};
+
+template <typename T, MMapMode M>
+struct A_Traits<MMapArray<T, M>> {
+  using ExprRef = const MMapArray<T, M>&;
+};
+
+// compressed sparse storage: the indices of the nonzero elements, in
+// increasing order, and their values. Expressions that multiply it with
+// dense arrays or scalars, or add it to other sparse operands, compute only
+// the nonzeros (see A_IsSparse); in dense expressions, elements are looked
+// up by binary search
+template <typename T>
+class SparseArray {
+ public:
+  // cursor over the stored elements
+  class Cursor {
+   public:
+    explicit Cursor(const SparseArray& a) : array(&a), pos(0){};
+
+    bool valid() const { return pos < array->indices.size(); }
+    size_t index() const { return array->indices[pos]; }
+    const T& value() const { return array->values[pos]; }
+    void next() { pos++; }
+
+   private:
+    const SparseArray* array;
+    size_t pos;
+  };
+
+  // create an array of `s` zeros
+  explicit SparseArray(size_t s) : storage_size(s){};
+
+  // return size (including the zeros)
+  size_t size() const { return storage_size; }
+
+  // number of stored elements
+  size_t nonzeros() const { return indices.size(); }
+
+  // store element `idx`; elements are appended in increasing index order
+  void push_back(size_t idx, const T& value) {
+    assert(idx < size());
+    assert(indices.empty() || indices.back() < idx);
+    indices.push_back(idx);
+    values.push_back(value);
+  }
+
+  // value of element `idx`, zero if it is not stored
+  T operator[](size_t idx) const {
+    auto pos = std::lower_bound(indices.begin(), indices.end(), idx);
+    if (pos == indices.end() || *pos != idx) {
+      return T();
+    }
+    return values[pos - indices.begin()];
+  }
+
+  Cursor cursor() const { return Cursor(*this); }
+
+  void print() const {
+    std::cout << "[";
+    for (size_t i = 0; i < storage_size - 1; i++) {
+      std::cout << (*this)[i] << ", ";
+    }
+    std::cout << (*this)[storage_size - 1] << "]\n";
+  }
+
+ private:
+  std::vector<size_t> indices;
+  std::vector<T> values;
+  size_t storage_size;
+};
+
+template <typename T>
+struct A_Traits<SparseArray<T>> {
+  using ExprRef = const SparseArray<T>&;
+};
+
+template <typename T>
+struct A_IsSparse<SparseArray<T>> : true_type {};
+
+template <typename T, typename OP1, typename OP2>
+struct A_IsSparse<A_Mult<T, OP1, OP2>>
+    : bool_constant<A_IsSparse<OP1>::value || A_IsSparse<OP2>::value> {};
+
+template <typename T, typename OP1, typename OP2>
+struct A_IsSparse<A_Add<T, OP1, OP2>>
+    : bool_constant<A_IsSparse<OP1>::value && A_IsSparse<OP2>::value> {};
+
+// class for objects that represent a contiguous subrange of existing
+// storage; the view does not own the elements it refers to
+template <typename T>
+class A_Slice {
+ public:
+  // constructor initializes the first element and the number of elements
+  A_Slice(T* first, size_t n) : base(first), count(n){};
+
+  const T& operator[](size_t idx) const { return base[idx]; }
+  T& operator[](size_t idx) { return base[idx]; }
+
+  size_t size() const { return count; }
+
+  // a slice is contiguous, so it can be sliced again
+  const T* data() const { return base; }
+  T* data() { return base; }
+
+  void print() const {
+    std::cout << "[";
+    for (size_t i = 0; i < count - 1; i++) {
+      std::cout << base[i] << ", ";
+    }
+    std::cout << base[count - 1] << "]\n";
+  }
+
+ private:
+  T* base;
+  size_t count;
+};
+
+// class for objects that represent every `step`-th element of existing
+// storage, starting at a given element
+template <typename T>
+class A_Stride {
+ public:
+  // constructor initializes the first element, the number of elements and
+  // the distance between two consecutive elements
+  A_Stride(T* first, size_t n, size_t s) : base(first), count(n), step(s){};
+
+  const T& operator[](size_t idx) const { return base[idx * step]; }
+  T& operator[](size_t idx) { return base[idx * step]; }
+
+  size_t size() const { return count; }
+
+  void print() const {
+    std::cout << "[";
+    for (size_t i = 0; i < count - 1; i++) {
+      std::cout << base[i * step] << ", ";
+    }
+    std::cout << base[(count - 1) * step] << "]\n";
+  }
+
+ private:
+  T* base;
+  size_t count;
+  size_t step;
+};
+
+// class for objects that represent the elements of existing storage selected
+// by an array of indices (gather on read, scatter on write)
+template <typename T>
+class A_Gather {
+ public:
+  // constructor initializes the storage and the indices; both must outlive
+  // the view
+  A_Gather(T* b, const size_t* i, size_t n) : base(b), indices(i), count(n){};
+
+  const T& operator[](size_t idx) const { return base[indices[idx]]; }
+  T& operator[](size_t idx) { return base[indices[idx]]; }
+
+  size_t size() const { return count; }
+
+  void print() const {
+    std::cout << "[";
+    for (size_t i = 0; i < count - 1; i++) {
+      std::cout << base[indices[i]] << ", ";
+    }
+    std::cout << base[indices[count - 1]] << "]\n";
+  }
+
+ private:
+  T* base;
+  const size_t* indices;
+  size_t count;
+};
+
+/*=====================Generator leaves=====================*/
+
+// class for objects that represent the sequence start, start + 1, ...;
+// elements are computed from their index, so the sequence takes no storage
+template <typename T>
+class A_Iota {
+ public:
+  A_Iota(T s, size_t n) : start(s), count(n){};
+
+  T operator[](size_t idx) const { return start + static_cast<T>(idx); }
+
+  size_t size() const { return count; }
+
+  void print() const {
+    std::cout << "[";
+    for (size_t i = 0; i < count - 1; i++) {
+      std::cout << (*this)[i] << ", ";
+    }
+    std::cout << (*this)[count - 1] << "]\n";
+  }
+
+ private:
+  T start;
+  size_t count;
+};
+
+// class for objects that represent `n` evenly spaced values from `first` to
+// `last` (both included)
+template <typename T>
+class A_Linspace {
+ public:
+  A_Linspace(T f, T l, size_t n)
+      : first(f), last(l), step(n > 1 ? (l - f) / static_cast<T>(n - 1) : T()),
+        count(n){};
+
+  // the last element is `last` exactly rather than first + (n - 1) * step
+  T operator[](size_t idx) const {
+    T value = first + static_cast<T>(idx) * step;
+    return idx == count - 1 ? last : value;
+  }
+
+  size_t size() const { return count; }
+
+  void print() const {
+    std::cout << "[";
+    for (size_t i = 0; i < count - 1; i++) {
+      std::cout << (*this)[i] << ", ";
+    }
+    std::cout << (*this)[count - 1] << "]\n";
+  }
+
+ private:
+  T first;
+  T last;
+  T step;
+  size_t count;
+};
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as
+// 1, 2, 3"): a counter-based generator, whose output is a bijection of the
+// counter keyed by the seed. Element idx of a random sequence is computed
+// from idx alone, so random sequences are evaluated in any order (or in
+// parallel) and need no state
+inline array<uint32_t, 4> A_philox(uint64_t counter, uint64_t seed) {
+  array<uint32_t, 4> ctr = {static_cast<uint32_t>(counter),
+                            static_cast<uint32_t>(counter >> 32), 0, 0};
+  uint32_t key0 = static_cast<uint32_t>(seed);
+  uint32_t key1 = static_cast<uint32_t>(seed >> 32);
+  for (int round = 0; round < 10; round++) {
+    uint64_t p0 = uint64_t(0xD2511F53) * ctr[0];
+    uint64_t p1 = uint64_t(0xCD9E8D57) * ctr[2];
+    ctr = {static_cast<uint32_t>(p1 >> 32) ^ ctr[1] ^ key0,
+           static_cast<uint32_t>(p1),
+           static_cast<uint32_t>(p0 >> 32) ^ ctr[3] ^ key1,
+           static_cast<uint32_t>(p0)};
+    key0 += 0x9E3779B9;
+    key1 += 0xBB67AE85;
+  }
+  return ctr;
+}
+
+// uniform value in [0, 1) from the random words `hi` and `lo`, with the full
+// precision of T
+template <typename T>
+T A_unit(uint32_t hi, uint32_t lo) {
+  if constexpr (is_same_v<T, float>) {
+    return static_cast<T>(hi >> 8) * 0x1p-24f;
+  } else {
+    return static_cast<T>(((uint64_t(hi) << 32) | lo) >> 11) * 0x1p-53;
+  }
+}
+
+// class for objects that represent `n` independent values uniformly
+// distributed in [0, 1), determined by `seed`
+template <typename T>
+class A_Uniform {
+ public:
+  static_assert(is_floating_point_v<T>, "random values are float or double");
+
+  A_Uniform(uint64_t s, size_t n) : seed(s), count(n){};
+
+  T operator[](size_t idx) const {
+    array<uint32_t, 4> r = A_philox(idx, seed);
+    return A_unit<T>(r[0], r[1]);
+  }
+
+  size_t size() const { return count; }
+
+  void print() const {
+    std::cout << "[";
+    for (size_t i = 0; i < count - 1; i++) {
+      std::cout << (*this)[i] << ", ";
+    }
+    std::cout << (*this)[count - 1] << "]\n";
+  }
+
+ private:
+  uint64_t seed;
+  size_t count;
+};
+
+// class for objects that represent `n` independent standard normal values,
+// determined by `seed`, by the Box-Muller transform of two uniform values
+template <typename T>
+class A_Normal {
+ public:
+  static_assert(is_floating_point_v<T>, "random values are float or double");
+
+  A_Normal(uint64_t s, size_t n) : seed(s), count(n){};
+
+  T operator[](size_t idx) const {
+    array<uint32_t, 4> r = A_philox(idx, seed);
+    T u1 = T(1) - A_unit<T>(r[0], r[1]);  // in (0, 1], so the log is finite
+    T u2 = A_unit<T>(r[2], r[3]);
+    return std::sqrt(T(-2) * std::log(u1)) *
+           std::cos(T(2) * std::numbers::pi_v<T> * u2);
+  }
+
+  size_t size() const { return count; }
+
+  void print() const {
+    std::cout << "[";
+    for (size_t i = 0; i < count - 1; i++) {
+      std::cout << (*this)[i] << ", ";
+    }
+    std::cout << (*this)[count - 1] << "]\n";
+  }
+
+ private:
+  uint64_t seed;
+  size_t count;
+};
+
+// largest compile-time size for which Array assignment is unrolled
+inline constexpr size_t A_UnrollSize = 16;
+
+// whether evaluating expression `e` reads the storage starting at `p`.
+// Leaves other than storage arrays, scalars and generators (views, ...)
+// conservatively count as reading it
+template <typename E>
+bool A_reads([[maybe_unused]] const E& e, [[maybe_unused]] const void* p) {
+  return true;
+}
+
+template <typename T>
+bool A_reads(const SArray<T>& a, const void* p) {
+  return a.data() == p;
+}
+
+template <typename T>
+bool A_reads(const A_Scalar<T>&, const void*) {
+  return false;
+}
+
+template <typename T>
+bool A_reads(const A_Iota<T>&, const void*) {
+  return false;
+}
+
+template <typename T>
+bool A_reads(const A_Linspace<T>&, const void*) {
+  return false;
+}
+
+template <typename T>
+bool A_reads(const A_Uniform<T>&, const void*) {
+  return false;
+}
+
+template <typename T>
+bool A_reads(const A_Normal<T>&, const void*) {
+  return false;
+}
+
+template <typename T, typename OP1, typename OP2>
+bool A_reads(const A_Add<T, OP1, OP2>& e, const void* p) {
+  return A_reads(e.lhs(), p) || A_reads(e.rhs(), p);
+}
+
+template <typename T, typename OP1, typename OP2>
+bool A_reads(const A_Mult<T, OP1, OP2>& e, const void* p) {
+  return A_reads(e.lhs(), p) || A_reads(e.rhs(), p);
+}
+
+template <typename T, typename OP1, typename OP2, typename OP3>
+bool A_reads(const A_FMA<T, OP1, OP2, OP3>& e, const void* p) {
+  return A_reads(e.factor1(), p) || A_reads(e.factor2(), p) ||
+         A_reads(e.addend(), p);
+}
+
+template <typename T, typename OP1, typename OP2, typename Cmp>
+bool A_reads(const A_Compare<T, OP1, OP2, Cmp>& e, const void* p) {
+  return A_reads(e.lhs(), p) || A_reads(e.rhs(), p);
+}
+
+template <typename T, typename C, typename OP1, typename OP2>
+bool A_reads(const A_Select<T, C, OP1, OP2>& e, const void* p) {
+  return A_reads(e.condition(), p) || A_reads(e.lhs(), p) ||
+         A_reads(e.rhs(), p);
+}
+
+// size in bytes above which Array assignment writes its result with
+// non-temporal (streaming) stores: a result larger than the last-level
+// cache cannot stay in it and would only evict the operands, and streaming
+// stores also skip reading each destination line before overwriting it.
+// Destinations that the expression also reads are not streamed: the read
+// has already brought each line into the cache, and the streaming store
+// would evict it
+inline size_t A_stream_threshold() {
+  static const size_t bytes = [] {
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    long llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (llc > 0) {
+      return static_cast<size_t>(llc);
+    }
+#endif
+    return size_t(32) << 20;
+  }();
+  return bytes;
+}
+
+#ifdef __SSE2__
+// out[idx] = expr[idx] for idx < n, with streaming stores (float and double
+// elements). Elements are computed a cache line at a time into an aligned
+// local block, which the compiler vectorizes like the plain loop, and the
+// block is then streamed out. The expression tree is copied into a local
+// (as in Array assignment), which the stores provably do not modify, so
+// that its scalars and storage pointers stay in registers
+template <typename T, typename E>
+void A_stream(T* out, const E& e, size_t n) {
+  const typename A_Traits<E>::ExprRef expr = e;
+  constexpr size_t L = 64 / sizeof(T);  // elements per cache line
+  size_t idx = 0;
+  // streaming stores need 16-byte alignment
+  for (; idx < n && reinterpret_cast<uintptr_t>(out + idx) % 16 != 0; idx++) {
+    out[idx] = expr[idx];
+  }
+  for (; idx + L <= n; idx += L) {
+    alignas(64) T v[L];
+    for (size_t k = 0; k < L; k++) {
+      v[k] = expr[idx + k];
+    }
+    for (size_t k = 0; k < L; k += 16 / sizeof(T)) {
+      if constexpr (is_same_v<T, float>) {
+        _mm_stream_ps(out + idx + k, _mm_load_ps(v + k));
+      } else {
+        _mm_stream_pd(out + idx + k, _mm_load_pd(v + k));
+      }
+    }
+  }
+  for (; idx < n; idx++) {
+    out[idx] = expr[idx];
+  }
+  // streaming stores are weakly ordered: make them visible to other threads
+  // before the assignment returns
+  _mm_sfence();
+}
+#endif
+
+template <typename T, typename Rep = SArray<T>>
+class Array {
+ public:
+  // create array with initial size
+  explicit Array(size_t s) : expr_rep(s){};
+
+  // create array of the size fixed by its representation (e.g. stl::array),
+  // with value-initialized elements
+  Array() : expr_rep(){};
+
+  // create array from possible implementation
+  Array(const Rep& rb) : expr_rep(rb){};
+  Array(Rep&& rb) : expr_rep(std::move(rb)){};
+
+  // assignment operator for same type
+  Array& operator=(const Array& b) {
+    assign(b.rep());
+    return *this;
+  }
+
+  // assignment operator for arrays of different type
+  template <typename T2, typename Rep2>
+  Array& operator=(const Array<T2, Rep2>& b) {
+    assign(b.rep());
+    return *this;
+  }
+
+  // size is size of represented data
+  size_t size() const { return expr_rep.size(); }
+
+  // index operator for constants and variables
+  decltype(auto) operator[](size_t idx) const {
+    assert(idx < size());
+    return expr_rep[idx];
+  }
+  decltype(auto) operator[](size_t idx) {
+    assert(idx < size());
+    return expr_rep[idx];
+  }
+
+  // return what the array currently represents
+  const Rep& rep() const { return expr_rep; }
+
+  Rep& rep() { return expr_rep; }
+
+  // representations without a print() of their own (such as stl::array)
+  // are printed element by element
+  void print() const {
+    if constexpr (requires { expr_rep.print(); }) {
+      expr_rep.print();
+    } else {
+      std::cout << "[";
+      size_t n = size();
+      for (size_t i = 0; i < n - 1; i++) {
+        std::cout << (*this)[i] << ", ";
+      }
+      std::cout << (*this)[n - 1] << "]\n";
+    }
+  }
+
+ private:
+  // evaluate expression `b` into the represented data
+  template <typename Rep2>
+  void assign(const Rep2& b) {
+    if constexpr (A_IsSparse<Rep>::value || A_IsSparse<Rep2>::value) {
+      assign_sparse(b);
+    } else {
+      assign_dense(b);
+    }
+  }
+
+  // evaluate dense expression `b` into dense storage. The rewritten
+  // expression tree (see optimize()) is held in a local (storage is still
+  // referred to by reference): the destination cannot alias the local, so
+  // scalars in the tree are loaded (and broadcast into vector registers)
+  // once rather than every iteration. When the size is fixed at compile
+  // time, small arrays are evaluated by a fully unrolled sequence of
+  // element assignments rather than a loop; results larger than the
+  // last-level cache are written with streaming stores
+  template <typename Rep2>
+  void assign_dense(const Rep2& b) {
+    using Opt = remove_cvref_t<decltype(optimize(b))>;
+    const typename A_Traits<Opt>::ExprRef expr = optimize(b);
+    assert(size() == expr.size());
+    constexpr size_t N = A_StaticSizeOf<Rep, Opt>::value;
+    if constexpr (N != 0 && N <= A_UnrollSize) {
+      [&]<size_t... I>(std::index_sequence<I...>) {
+        ((expr_rep[I] = expr[I]), ...);
+      }(std::make_index_sequence<N>());
+    } else {
+      size_t n = N != 0 ? N : expr.size();
+#ifdef __SSE2__
+      if constexpr (is_same_v<Rep, SArray<T>> &&
+                    (is_same_v<T, float> || is_same_v<T, double>)) {
+        if (n * sizeof(T) > A_stream_threshold() &&
+            !A_reads(expr, expr_rep.data())) {
+          A_stream(expr_rep.data(), expr, n);
+          return;
+        }
+      }
+#endif
+      for (size_t idx = 0; idx < n; idx++) {
+        expr_rep[idx] = expr[idx];
+      }
+    }
+  }
+
+  // evaluate expression `b` when it or the destination is sparse: only the
+  // nonzeros of a sparse expression are computed (without rewriting), into
+  // a temporary since the destination may be one of the operands, and a
+  // dense expression is compressed into sparse storage
+  template <typename Rep2>
+  void assign_sparse(const Rep2& b) {
+    assert(size() == b.size());
+    size_t n = b.size();
+    SparseArray<T> result(n);
+    if constexpr (A_IsSparse<Rep2>::value) {
+      for (auto c = b.cursor(); c.valid(); c.next()) {
+        result.push_back(c.index(), static_cast<T>(c.value()));
+      }
+    } else {
+      for (size_t idx = 0; idx < n; idx++) {
+        T value = static_cast<T>(b[idx]);
+        if (value != T()) {
+          result.push_back(idx, value);
+        }
+      }
+    }
+    if constexpr (is_same_v<Rep, SparseArray<T>>) {
+      expr_rep = std::move(result);
+    } else {
+      for (size_t idx = 0; idx < n; idx++) {
+        expr_rep[idx] = T();
+      }
+      for (auto c = result.cursor(); c.valid(); c.next()) {
+        expr_rep[c.index()] = c.value();
+      }
+    }
+  }
+
+  Rep expr_rep;  // (access to) the data of the array
+};
+
+// Array of N elements held in an stl::array, e.g. a small geometric
+// vector: expressions over it have their size known at compile time
+template <typename T, size_t N>
+using FixedArray = Array<T, array<T, N>>;
+
+// whether an operand of an Array or Tensor operator is a scalar: an
+// arithmetic type or a 16-bit float. Other operands take no part in overload
+// resolution, instead of failing deep inside the expression
+template <typename S>
+struct A_IsScalarOperand : bool_constant<is_arithmetic_v<S>> {};
+
+template <>
+struct A_IsScalarOperand<bfloat16> : true_type {};
+
+template <>
+struct A_IsScalarOperand<float16> : true_type {};
+
+template <typename S>
+using A_EnableIfScalar = enable_if_t<A_IsScalarOperand<S>::value>;
+
+// addition of two Arrays; the element type is the common type of the
+// operands' element types, so Array<float> + Array<double> is computed in
+// double and Array<bfloat16> + Array<bfloat16> in float
+template <typename T1, typename R1, typename T2, typename R2>
+auto operator+(const Array<T1, R1>& a, const Array<T2, R2>& b) {
+  using T = A_Promote_t<T1, T2>;
+  return Array<T, A_Add<T, R1, R2>>(A_Add<T, R1, R2>(a.rep(), b.rep()));
+}
+
+// addition of Array and scalar
+template <typename T1, typename R1, typename S, typename = A_EnableIfScalar<S>>
+auto operator+(const Array<T1, R1>& a, const S& s) {
+  using T = A_Promote_t<T1, S>;
+  return Array<T, A_Add<T, R1, A_Scalar<T>>>(
+      A_Add<T, R1, A_Scalar<T>>(a.rep(), A_Scalar<T>(s)));
+}
+
+// addition of scalar and Array
+template <typename S, typename T2, typename R2, typename = A_EnableIfScalar<S>>
+auto operator+(const S& s, const Array<T2, R2>& b) {
+  using T = A_Promote_t<S, T2>;
+  return Array<T, A_Add<T, A_Scalar<T>, R2>>(
+      A_Add<T, A_Scalar<T>, R2>(A_Scalar<T>(s), b.rep()));
+}
+
+// multiplication of two Arrays
+template <typename T1, typename R1, typename T2, typename R2>
+auto operator*(const Array<T1, R1>& a, const Array<T2, R2>& b) {
+  using T = A_Promote_t<T1, T2>;
+  return Array<T, A_Mult<T, R1, R2>>(A_Mult<T, R1, R2>(a.rep(), b.rep()));
+}
+
+// multiplication of Array and scalar
+template <typename T1, typename R1, typename S, typename = A_EnableIfScalar<S>>
+auto operator*(const Array<T1, R1>& a, const S& s) {
+  using T = A_Promote_t<T1, S>;
+  return Array<T, A_Mult<T, R1, A_Scalar<T>>>(
+      A_Mult<T, R1, A_Scalar<T>>(a.rep(), A_Scalar<T>(s)));
+}
+
+// multiplication of scalar and Array
+template <typename S, typename T2, typename R2, typename = A_EnableIfScalar<S>>
+auto operator*(const S& s, const Array<T2, R2>& b) {
+  using T = A_Promote_t<S, T2>;
+  return Array<T, A_Mult<T, A_Scalar<T>, R2>>(
+      A_Mult<T, A_Scalar<T>, R2>(A_Scalar<T>(s), b.rep()));
+}
+
+// element type and representation of an operand of a comparison or of
+// where(): an Array contributes its expression, a scalar becomes an
+// A_Scalar of the element type T of the operation
+template <typename X>
+struct A_Operand {
+  using Type = X;
+  template <typename T>
+  using Rep = A_Scalar<T>;
+  template <typename T>
+  static A_Scalar<T> rep(const X& x) {
+    return A_Scalar<T>(x);
+  }
+};
+
+template <typename T1, typename R1>
+struct A_Operand<Array<T1, R1>> {
+  using Type = T1;
+  template <typename T>
+  using Rep = R1;
+  template <typename T>
+  static const R1& rep(const Array<T1, R1>& a) {
+    return a.rep();
+  }
+};
+
+template <typename X>
+struct A_IsArray : false_type {};
+
+template <typename T, typename Rep>
+struct A_IsArray<Array<T, Rep>> : true_type {};
+
+// operands of a comparison: two Arrays, or an Array and a scalar
+template <typename A, typename B>
+using A_EnableIfCompare =
+    enable_if_t<(A_IsArray<A>::value || A_IsArray<B>::value) &&
+                (A_IsArray<A>::value || A_IsScalarOperand<A>::value) &&
+                (A_IsArray<B>::value || A_IsScalarOperand<B>::value)>;
+
+// lazy mask comparing `a` and `b` with Cmp in their promoted element type
+template <template <typename> class Cmp, typename A, typename B>
+auto A_compare(const A& a, const B& b) {
+  using T = A_Promote_t<typename A_Operand<A>::Type,
+                        typename A_Operand<B>::Type>;
+  using R1 = typename A_Operand<A>::template Rep<T>;
+  using R2 = typename A_Operand<B>::template Rep<T>;
+  return Array<bool, A_Compare<T, R1, R2, Cmp<T>>>(A_Compare<T, R1, R2, Cmp<T>>(
+      A_Operand<A>::template rep<T>(a), A_Operand<B>::template rep<T>(b)));
+}
+
+// elementwise comparisons of Arrays with Arrays or scalars; the results are
+// Arrays of bool evaluated lazily like any other expression
+template <typename A, typename B, typename = A_EnableIfCompare<A, B>>
+auto operator<(const A& a, const B& b) {
+  return A_compare<std::less>(a, b);
+}
+
+template <typename A, typename B, typename = A_EnableIfCompare<A, B>>
+auto operator<=(const A& a, const B& b) {
+  return A_compare<std::less_equal>(a, b);
+}
+
+template <typename A, typename B, typename = A_EnableIfCompare<A, B>>
+auto operator>(const A& a, const B& b) {
+  return A_compare<std::greater>(a, b);
+}
+
+template <typename A, typename B, typename = A_EnableIfCompare<A, B>>
+auto operator>=(const A& a, const B& b) {
+  return A_compare<std::greater_equal>(a, b);
+}
+
+template <typename A, typename B, typename = A_EnableIfCompare<A, B>>
+auto operator==(const A& a, const B& b) {
+  return A_compare<std::equal_to>(a, b);
+}
+
+template <typename A, typename B, typename = A_EnableIfCompare<A, B>>
+auto operator!=(const A& a, const B& b) {
+  return A_compare<std::not_equal_to>(a, b);
+}
+
+// elementwise `cond ? a : b`, where `a` and `b` are Arrays or scalars; the
+// selection is evaluated in the same loop as the rest of the expression, so
+// e.g. a clamp
+//   y = where(x < lo, lo, where(x > hi, hi, x)) * s;
+// makes one pass over x without materializing the masks
+template <typename TC, typename RC, typename A, typename B,
+          typename = A_EnableIfCompare<Array<TC, RC>, A>,
+          typename = A_EnableIfCompare<Array<TC, RC>, B>>
+auto where(const Array<TC, RC>& cond, const A& a, const B& b) {
+  using T = A_Promote_t<typename A_Operand<A>::Type,
+                        typename A_Operand<B>::Type>;
+  using R1 = typename A_Operand<A>::template Rep<T>;
+  using R2 = typename A_Operand<B>::template Rep<T>;
+  return Array<T, A_Select<T, RC, R1, R2>>(
+      A_Select<T, RC, R1, R2>(cond.rep(), A_Operand<A>::template rep<T>(a),
+                              A_Operand<B>::template rep<T>(b)));
+}
+
+// N-dimensional storage: a contiguous row-major SArray plus its shape
+template <typename T, size_t N>
+class STensor {
+ public:
+  static_assert(N > 0, "tensors have at least one dimension");
+
+  // create tensor with the given shape
+  explicit STensor(const A_Shape<N>& s) : storage(s.count()), dims(s){};
+
+  const A_Shape<N>& shape() const { return dims; }
+
+  // size is the total number of elements
+  size_t size() const { return storage.size(); }
+
+  // index operator on the flattened (row-major) elements
+  const T& operator[](size_t idx) const { return storage[idx]; }
+  T& operator[](size_t idx) { return storage[idx]; }
+
+  const T* data() const { return storage.data(); }
+  T* data() { return storage.data(); }
+
+  // position of the element at index `idx` in the flattened elements
+  size_t offset(const A_Shape<N>& idx) const {
+    size_t pos = 0;
+    for (size_t k = 0; k < N; k++) {
+      assert(idx[k] < dims[k]);
+      pos = pos * dims[k] + idx[k];
+    }
+    return pos;
+  }
+
+  // innermost row at the index `idx`, whose rank may exceed that of the
+  // tensor (leading dimensions are then ignored); dimensions of extent 1 are
+  // broadcast by not advancing along them
+  template <size_t K>
+  A_Stride<const T> row(const A_Shape<K>& idx) const {
+    static_assert(K >= N, "index has a lower rank than the tensor");
+    size_t pos = 0;
+    size_t stride = dims[N - 1];
+    for (size_t k = N - 1; k-- > 0;) {
+      if (dims[k] != 1) {
+        pos += idx[K - N + k] * stride;
+      }
+      stride *= dims[k];
+    }
+    // an innermost extent of 1 gives a row of size 0, i.e. a broadcast value
+    size_t inner = dims[N - 1];
+    return inner == 1 ? A_Stride<const T>(data() + pos, 0, 0)
+                      : A_Stride<const T>(data() + pos, inner, 1);
+  }
+
+  void print() const { storage.print(); }
+
+ private:
+  SArray<T> storage;
+  A_Shape<N> dims;
+};
+
+template <typename T, size_t N, typename Rep = STensor<T, N>>
+class Tensor {
+ public:
+  // create tensor with the given extents
+  template <typename... Extents,
+            typename = enable_if_t<sizeof...(Extents) == N>>
+  explicit Tensor(Extents... extents)
+      : expr_rep(A_Shape<N>{{static_cast<size_t>(extents)...}}){};
+
+  // create tensor with the given shape
+  explicit Tensor(const A_Shape<N>& s) : expr_rep(s){};
+
+  // create tensor from possible implementation
+  Tensor(const Rep& rb) : expr_rep(rb){};
+
+  // assignment operator for same type
+  Tensor& operator=(const Tensor& b) {
+    assign(b.rep());
+    return *this;
+  }
+
+  // assignment operator for tensors of different type; the shape of `b` is
+  // broadcast to the shape of this tensor
+  template <typename T2, size_t N2, typename Rep2>
+  Tensor& operator=(const Tensor<T2, N2, Rep2>& b) {
+    static_assert(N2 <= N, "cannot assign a tensor of higher rank");
+    assign(b.rep());
+    return *this;
+  }
+
+  // assignment of a product: the kernel writes straight into this tensor
+  template <typename OP1, typename OP2>
+  Tensor& operator=(const Tensor<T, N, A_MatMul<T, OP1, OP2, N>>& b) {
+    static_assert(is_same_v<Rep, STensor<T, N>>);
+    assert(shape() == b.shape());
+    b.rep().evaluate_into(expr_rep.data());
+    return *this;
+  }
+
+  A_Shape<N> shape() const { return expr_rep.shape(); }
+
+  // element access for constants, variables and expressions
+  template <typename... Indices>
+  decltype(auto) operator()(Indices... indices) const {
+    static_assert(sizeof...(Indices) == N);
+    A_Shape<N> idx{{static_cast<size_t>(indices)...}};
+    return expr_rep.row(idx)[idx[N - 1]];
+  }
+  template <typename... Indices>
+  decltype(auto) operator()(Indices... indices) {
+    static_assert(sizeof...(Indices) == N);
+    if constexpr (is_same_v<Rep, STensor<T, N>>) {
+      return expr_rep[expr_rep.offset({{static_cast<size_t>(indices)...}})];
+    } else {
+      return static_cast<const Tensor&>(*this)(indices...);
+    }
+  }
+
+  // return what the tensor currently represents
+  const Rep& rep() const { return expr_rep; }
+
+  Rep& rep() { return expr_rep; }
+
+  // print one innermost row per line
+  void print() const {
+    using Opt = remove_cvref_t<decltype(optimize(expr_rep))>;
+    const typename A_Traits<Opt>::ExprRef expr = optimize(expr_rep);
+    A_Shape<N> dims = shape();
+    for_each_row(dims, [&](const A_Shape<N>& idx) {
+      auto line = expr.row(idx);
+      std::cout << "[";
+      for (size_t j = 0; j + 1 < dims[N - 1]; j++) {
+        std::cout << line[j] << ", ";
+      }
+      std::cout << line[dims[N - 1] - 1] << "]\n";
+    });
+  }
+
+ private:
+  // call `f` with the index of each innermost row in row-major order
+  template <typename F>
+  static void for_each_row(const A_Shape<N>& dims, F&& f) {
+    if (dims.count() == 0) {
+      return;
+    }
+    A_Shape<N> idx{};
+    for (size_t r = 0, rows = dims.count() / dims[N - 1]; r < rows; r++) {
+      f(idx);
+      // advance the outer index, last outer dimension fastest
+      for (size_t k = N - 1; k-- > 0;) {
+        if (++idx[k] < dims[k]) {
+          break;
+        }
+        idx[k] = 0;
+      }
+    }
+  }
+
+  // evaluate expression `b` row by row: the innermost dimension of the
+  // destination is contiguous, so the inner loop is a plain indexed store
+  template <typename Rep2>
+  void assign(const Rep2& b) {
+    using Opt = remove_cvref_t<decltype(optimize(b))>;
+    const typename A_Traits<Opt>::ExprRef expr = optimize(b);
+    const A_Shape<N>& dims = expr_rep.shape();
+    assert(broadcast_shape(dims, expr.shape()) == dims);
+    size_t inner = dims[N - 1];
+    T* out = expr_rep.data();
+    for_each_row(dims, [&](const A_Shape<N>& idx) {
+      auto line = expr.row(idx);
+      for (size_t j = 0; j < inner; j++) {
+        out[j] = line[j];
+      }
+      out += inner;
+    });
+  }
+
+  Rep expr_rep;  // (access to) the data of the tensor
+};
+
+// addition of two Tensors; the result has the broadcast shape and the
+// promoted element type
+template <typename T1, size_t N1, typename R1, typename T2, size_t N2,
+          typename R2>
+auto operator+(const Tensor<T1, N1, R1>& a, const Tensor<T2, N2, R2>& b) {
+  using T = A_Promote_t<T1, T2>;
+  return Tensor<T, (N1 > N2 ? N1 : N2), A_Add<T, R1, R2>>(
+      A_Add<T, R1, R2>(a.rep(), b.rep()));
+}
+
+// addition of Tensor and scalar
+template <typename T1, size_t N, typename R1, typename S,
+          typename = A_EnableIfScalar<S>>
+auto operator+(const Tensor<T1, N, R1>& a, const S& s) {
+  using T = A_Promote_t<T1, S>;
+  return Tensor<T, N, A_Add<T, R1, A_Scalar<T>>>(
+      A_Add<T, R1, A_Scalar<T>>(a.rep(), A_Scalar<T>(s)));
+}
+
+// addition of scalar and Tensor
+template <typename S, typename T2, size_t N, typename R2,
+          typename = A_EnableIfScalar<S>>
+auto operator+(const S& s, const Tensor<T2, N, R2>& b) {
+  using T = A_Promote_t<S, T2>;
+  return Tensor<T, N, A_Add<T, A_Scalar<T>, R2>>(
+      A_Add<T, A_Scalar<T>, R2>(A_Scalar<T>(s), b.rep()));
+}
+
+// multiplication of two Tensors; the result has the broadcast shape and the
+// promoted element type
+template <typename T1, size_t N1, typename R1, typename T2, size_t N2,
+          typename R2>
+auto operator*(const Tensor<T1, N1, R1>& a, const Tensor<T2, N2, R2>& b) {
+  using T = A_Promote_t<T1, T2>;
+  return Tensor<T, (N1 > N2 ? N1 : N2), A_Mult<T, R1, R2>>(
+      A_Mult<T, R1, R2>(a.rep(), b.rep()));
+}
+
+// multiplication of Tensor and scalar
+template <typename T1, size_t N, typename R1, typename S,
+          typename = A_EnableIfScalar<S>>
+auto operator*(const Tensor<T1, N, R1>& a, const S& s) {
+  using T = A_Promote_t<T1, S>;
+  return Tensor<T, N, A_Mult<T, R1, A_Scalar<T>>>(
+      A_Mult<T, R1, A_Scalar<T>>(a.rep(), A_Scalar<T>(s)));
+}
+
+// multiplication of scalar and Tensor
+template <typename S, typename T2, size_t N, typename R2,
+          typename = A_EnableIfScalar<S>>
+auto operator*(const S& s, const Tensor<T2, N, R2>& b) {
+  using T = A_Promote_t<S, T2>;
+  return Tensor<T, N, A_Mult<T, A_Scalar<T>, R2>>(
+      A_Mult<T, A_Scalar<T>, R2>(A_Scalar<T>(s), b.rep()));
+}
+
+namespace matmul_impl {
+
+// register tile of the micro-kernel (MR rows of A times NR columns of B) and
+// cache blocks: a KC x NC block of B is packed once and reused for every
+// MC x KC block of A, which stays in L2 while the micro-kernel streams it
+inline constexpr size_t MR = 4;
+inline constexpr size_t NR = 8;
+inline constexpr size_t MC = 96;
+inline constexpr size_t KC = 256;
+inline constexpr size_t NC = 1024;
+
+// copy an mc x kc block of A into MR-row panels, column by column, padding
+// the last panel with zeros so the micro-kernel has fixed trip counts
+template <typename T>
+void pack_a(const T* a, size_t lda, size_t mc, size_t kc, T* buf) {
+  for (size_t ir = 0; ir < mc; ir += MR) {
+    for (size_t p = 0; p < kc; p++) {
+      for (size_t i = 0; i < MR; i++) {
+        *buf++ = ir + i < mc ? a[(ir + i) * lda + p] : T();
+      }
+    }
+  }
+}
+
+// copy a kc x nc block of B into NR-column panels, row by row, padding the
+// last panel with zeros
+template <typename T>
+void pack_b(const T* b, size_t ldb, size_t kc, size_t nc, T* buf) {
+  for (size_t jr = 0; jr < nc; jr += NR) {
+    for (size_t p = 0; p < kc; p++) {
+      for (size_t j = 0; j < NR; j++) {
+        *buf++ = jr + j < nc ? b[p * ldb + jr + j] : T();
+      }
+    }
+  }
+}
+
+// C[mr x nr] += A panel * B panel; the MR x NR accumulators are a fixed-size
+// local array, which the compiler keeps in (vector) registers
+template <typename T>
+void micro_kernel(size_t kc, const T* a, const T* b, T* c, size_t ldc,
+                  size_t mr, size_t nr) {
+  T acc[MR][NR] = {};
+  for (size_t p = 0; p < kc; p++, a += MR, b += NR) {
+    for (size_t i = 0; i < MR; i++) {
+      for (size_t j = 0; j < NR; j++) {
+        acc[i][j] += a[i] * b[j];
+      }
+    }
+  }
+  for (size_t i = 0; i < mr; i++) {
+    for (size_t j = 0; j < nr; j++) {
+      c[i * ldc + j] += acc[i][j];
+    }
+  }
+}
+
+// C = A * B for row-major A (m x k), B (k x n) and C (m x n)
+template <typename T>
+void gemm(const T* a, const T* b, T* c, size_t m, size_t n, size_t k) {
+  std::fill(c, c + m * n, T());
+  std::vector<T> a_pack(MC * KC);
+  std::vector<T> b_pack(KC * ((std::min(n, NC) + NR - 1) / NR * NR));
+  for (size_t jc = 0; jc < n; jc += NC) {
+    size_t nc = std::min(NC, n - jc);
+    for (size_t pc = 0; pc < k; pc += KC) {
+      size_t kc = std::min(KC, k - pc);
+      pack_b(b + pc * n + jc, n, kc, nc, b_pack.data());
+      for (size_t ic = 0; ic < m; ic += MC) {
+        size_t mc = std::min(MC, m - ic);
+        pack_a(a + ic * k + pc, k, mc, kc, a_pack.data());
+        for (size_t jr = 0; jr < nc; jr += NR) {
+          for (size_t ir = 0; ir < mc; ir += MR) {
+            micro_kernel(kc, a_pack.data() + ir * kc, b_pack.data() + jr * kc,
+                         c + (ic + ir) * n + jc + jr, n,
+                         std::min(MR, mc - ir), std::min(NR, nc - jr));
+          }
+        }
+      }
+    }
+  }
+}
+
+// y = A * x for row-major A (m x n); four rows are processed together so
+// each load of x is reused four times
+template <typename T>
+void gemv(const T* a, const T* x, T* y, size_t m, size_t n) {
+  size_t i = 0;
+  for (; i + 4 <= m; i += 4) {
+    const T* a0 = a + i * n;
+    T s0 = T(), s1 = T(), s2 = T(), s3 = T();
+    for (size_t j = 0; j < n; j++) {
+      s0 += a0[j] * x[j];
+      s1 += a0[n + j] * x[j];
+      s2 += a0[2 * n + j] * x[j];
+      s3 += a0[3 * n + j] * x[j];
+    }
+    y[i] = s0;
+    y[i + 1] = s1;
+    y[i + 2] = s2;
+    y[i + 3] = s3;
+  }
+  for (; i < m; i++) {
+    T sum = T();
+    for (size_t j = 0; j < n; j++) {
+      sum += a[i * n + j] * x[j];
+    }
+    y[i] = sum;
+  }
+}
+
+// split the m rows of the result among `threads` threads; each thread runs
+// the serial kernel on its own band of rows of A and the result
+template <typename T>
+void product(const T* a, const T* b, T* c, size_t m, size_t n, size_t k,
+             bool is_gemv, size_t threads) {
+  auto band = [&](size_t first, size_t rows) {
+    if (is_gemv) {
+      gemv(a + first * k, b, c + first, rows, k);
+    } else {
+      gemm(a + first * k, b, c + first * n, rows, n, k);
+    }
+  };
+  threads = std::max<size_t>(1, std::min(threads, m / MR));
+  if (threads == 1) {
+    band(0, m);
+    return;
+  }
+  std::vector<std::thread> workers;
+  // whole tiles per band, rounded up so that at most `threads` bands cover m
+  size_t rows = ((m + threads - 1) / threads + MR - 1) / MR * MR;
+  for (size_t first = 0; first < m; first += rows) {
+    workers.emplace_back(band, first, std::min(rows, m - first));
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+};  // namespace matmul_impl
+
+// class for objects that represent the matrix product of a 2-dimensional
+// operand with a 2-dimensional (GEMM) or 1-dimensional (GEMV) operand. The
+// product is lazy: it is computed by the blocked kernels the first time a
+// row is requested and then acts like storage inside the enclosing
+// expression. Each evaluation of an expression works on a copy made by
+// optimize(), with a product of its own, so an expression evaluated again
+// after its operands change sees the new operands, and evaluations on
+// several threads do not share the product. Element access on the node
+// itself (operator() of a Tensor holding it) computes the product into the
+// node once, and is not synchronized
+template <typename T, typename OP1, typename OP2, size_t N>
+class A_MatMul {
+ public:
+  static_assert(N == 1 || N == 2, "matmul takes a matrix or a vector");
+
+  // constructor initializes (references to) operands; copies of this node
+  // share the computed product
+  A_MatMul(const OP1& a, const OP2& b, size_t t)
+      : op1(a), op2(b), threads(t), result(std::make_shared<Cache>()) {
+    assert(op1.shape()[1] == op2.shape()[0]);
+  }
+
+  // operands and thread count, for making a node with a product of its own
+  // (see optimize())
+  const OP1& lhs() const { return op1; }
+  const OP2& rhs() const { return op2; }
+  size_t thread_count() const { return threads; }
+
+  A_Shape<N> shape() const {
+    if constexpr (N == 2) {
+      return {{op1.shape()[0], op2.shape()[1]}};
+    } else {
+      return {{op1.shape()[0]}};
+    }
+  }
+
+  template <size_t K>
+  auto row(const A_Shape<K>& idx) const {
+    if (!result->product) {
+      result->product.emplace(shape());
+      evaluate_into(result->product->data());
+    }
+    return result->product->row(idx);
+  }
+
+  // compute the product into the contiguous row-major storage `out`
+  void evaluate_into(T* out) const {
+    std::optional<Tensor<T, 2>> a_tmp;
+    std::optional<Tensor<T, N>> b_tmp;
+    const T* a = contiguous(op1, a_tmp);
+    const T* b = contiguous(op2, b_tmp);
+    size_t m = op1.shape()[0];
+    size_t k = op1.shape()[1];
+    size_t n = N == 2 ? op2.shape()[N - 1] : 1;
+    // the kernels read the operands while writing the result, so a result
+    // that overlaps an operand is computed into a temporary first
+    if (overlaps(out, m * n, a, m * k) || overlaps(out, m * n, b, k * n)) {
+      STensor<T, N> tmp(shape());
+      matmul_impl::product(a, b, tmp.data(), m, n, k, N == 1, threads);
+      std::copy(tmp.data(), tmp.data() + m * n, out);
+    } else {
+      matmul_impl::product(a, b, out, m, n, k, N == 1, threads);
+    }
+  }
+
+ private:
+  struct Cache {
+    std::optional<STensor<T, N>> product;
+  };
+
+  // pointer to the elements of operand `op`; expressions are evaluated into
+  // `tmp` first
+  template <typename OP, size_t R>
+  static const T* contiguous(const OP& op, std::optional<Tensor<T, R>>& tmp) {
+    if constexpr (is_same_v<OP, STensor<T, R>>) {
+      return op.data();
+    } else {
+      tmp.emplace(op.shape());
+      *tmp = Tensor<T, R, OP>(op);
+      return tmp->rep().data();
+    }
+  }
+
+  static bool overlaps(const T* p, size_t n, const T* q, size_t m) {
+    return p < q + m && q < p + n;
+  }
+
+  typename A_Traits<OP1>::ExprRef op1;
+  typename A_Traits<OP2>::ExprRef op2;
+  size_t threads;
+  std::shared_ptr<Cache> result;
+};
+
+// a product node with an empty product, so that each evaluation computes the
+// product from the current operands
+template <typename T, typename OP1, typename OP2, size_t N>
+A_MatMul<T, OP1, OP2, N> optimize(const A_MatMul<T, OP1, OP2, N>& e) {
+  return A_MatMul<T, OP1, OP2, N>(e.lhs(), e.rhs(), e.thread_count());
+}
+
+// matrix-matrix or matrix-vector product of `a` and `b`, computed on
+// `threads` threads when the result is evaluated
+template <typename T, typename R1, size_t N2, typename R2>
+auto matmul(const Tensor<T, 2, R1>& a, const Tensor<T, N2, R2>& b,
+            size_t threads = 1) {
+  return Tensor<T, N2, A_MatMul<T, R1, R2, N2>>(
+      A_MatMul<T, R1, R2, N2>(a.rep(), b.rep(), threads));
+}
+
+// sum of the elements of expression `a`. Eight partial sums break the
+// dependency chain of a single accumulator, so the loop can keep several
+// (vector) additions in flight; for floating point the result may differ
+// from a left-to-right sum in the last bits. Of a sparse expression, only
+// the nonzeros are visited. The sum is accumulated and returned in the
+// computation type, so a sum of bfloat16 or float16 elements is a float
+template <typename T, typename Rep>
+A_Compute_t<T> sum(const Array<T, Rep>& a) {
+  using C = A_Compute_t<T>;
+  if constexpr (A_IsSparse<Rep>::value) {
+    // only the nonzeros contribute
+    C total = C();
+    for (auto c = a.rep().cursor(); c.valid(); c.next()) {
+      total += static_cast<C>(c.value());
+    }
+    return total;
+  } else {
+    using Opt = remove_cvref_t<decltype(optimize(a.rep()))>;
+    const typename A_Traits<Opt>::ExprRef expr = optimize(a.rep());
+    size_t n = a.size();
+    C partial[8] = {};
+    size_t idx = 0;
+    for (; idx + 8 <= n; idx += 8) {
+      // evaluate the block before accumulating it, so that the element loads
+      // and the additions each form one straight run the compiler can vectorize
+      C block[8];
+      for (size_t k = 0; k < 8; k++) {
+        block[k] = static_cast<C>(expr[idx + k]);
+      }
+      for (size_t k = 0; k < 8; k++) {
+        partial[k] += block[k];
+      }
+    }
+    for (; idx < n; idx++) {
+      partial[0] += static_cast<C>(expr[idx]);
+    }
+    return ((partial[0] + partial[1]) + (partial[2] + partial[3])) +
+           ((partial[4] + partial[5]) + (partial[6] + partial[7]));
+  }
+}
+
+// class for objects that represent the result of an operation that cannot
+// be evaluated element by element, because each element depends on many
+// elements of the operand (scans and moving windows). The result is
+// computed into storage when the node is created and then acts as storage
+// inside the enclosing expression; copies of the node share it
+template <typename T>
+class A_Materialized {
+ public:
+  // constructor allocates the result, which the creator fills in
+  explicit A_Materialized(size_t n) : values(std::make_shared<SArray<T>>(n)){};
+
+  const T& operator[](size_t idx) const { return (*values)[idx]; }
+
+  size_t size() const { return values->size(); }
+
+  void print() const { values->print(); }
+
+  // the result, for the operation that computes it
+  T* data() { return values->data(); }
+
+ private:
+  std::shared_ptr<SArray<T>> values;
+};
+
+namespace scan_impl {
+
+// below this many elements a scan runs on the calling thread: starting the
+// threads costs more than the passes they share
+inline constexpr size_t ParallelSize = size_t(1) << 16;
+
+// call f(first, count) for the ranges of `len` elements that make up [0, n),
+// each on its own thread
+template <typename F>
+void parallel(size_t n, size_t len, F f) {
+  if (len >= n) {
+    f(0, n);
+    return;
+  }
+  std::vector<std::thread> workers;
+  for (size_t first = 0; first < n; first += len) {
+    workers.emplace_back(f, first, std::min(len, n - first));
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+// length of the ranges for splitting n elements among `threads` threads,
+// rounded up to a multiple of `unit`
+inline size_t range_length(size_t n, size_t threads, size_t unit = 1) {
+  threads = n < ParallelSize ? 1 : std::max<size_t>(1, threads);
+  size_t len = (n + threads - 1) / threads;
+  return std::max<size_t>(1, (len + unit - 1) / unit * unit);
+}
+
+// scan a block of eight elements in place (v[k] becomes v[0] + ... + v[k])
+// by three shifted additions (Hillis-Steele)
+template <typename T>
+void scan_block(T (&v)[8]) {
+  for (size_t d = 1; d < 8; d *= 2) {
+    for (size_t k = 7; k >= d; k--) {
+      v[k] += v[k - d];
+    }
+  }
+}
+
+#ifdef __SSE2__
+// the same for float and double, with the shifts done as byte shifts of
+// SSE registers: compilers do not vectorize the generic version
+template <int Bytes>
+__m128 shift_add(__m128 x) {
+  return _mm_add_ps(
+      x, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(x), Bytes)));
+}
+
+inline void scan_block(float (&v)[8]) {
+  __m128 lo = _mm_loadu_ps(v);
+  __m128 hi = _mm_loadu_ps(v + 4);
+  lo = shift_add<8>(shift_add<4>(lo));
+  hi = shift_add<8>(shift_add<4>(hi));
+  hi = _mm_add_ps(hi, _mm_shuffle_ps(lo, lo, _MM_SHUFFLE(3, 3, 3, 3)));
+  _mm_storeu_ps(v, lo);
+  _mm_storeu_ps(v + 4, hi);
+}
+
+inline void scan_block(double (&v)[8]) {
+  __m128d x[4];
+  for (size_t k = 0; k < 4; k++) {
+    x[k] = _mm_loadu_pd(v + 2 * k);
+    x[k] = _mm_add_pd(
+        x[k], _mm_castsi128_pd(_mm_slli_si128(_mm_castpd_si128(x[k]), 8)));
+  }
+  for (size_t k = 1; k < 4; k++) {
+    x[k] = _mm_add_pd(x[k], _mm_unpackhi_pd(x[k - 1], x[k - 1]));
+  }
+  for (size_t k = 0; k < 4; k++) {
+    _mm_storeu_pd(v + 2 * k, x[k]);
+  }
+}
+#endif
+
+// out[i] = carry + in[first] + ... + in[first + i] for i < n (without the
+// last term for an exclusive scan); returns carry plus all n elements.
+// Eight elements at a time are loaded into a local block and scanned in
+// place in vector registers (see scan_block()), so only the addition of the
+// carry is on the dependency chain from one block to the next
+template <bool Exclusive, typename T, typename E>
+T scan(const E& in, size_t first, T* out, size_t n, T carry) {
+  size_t idx = 0;
+  for (; idx + 8 <= n; idx += 8) {
+    T v[8];
+    for (size_t k = 0; k < 8; k++) {
+      v[k] = in[first + idx + k];
+    }
+    scan_block(v);
+    if constexpr (Exclusive) {
+      out[idx] = carry;
+      for (size_t k = 1; k < 8; k++) {
+        out[idx + k] = carry + v[k - 1];
+      }
+    } else {
+      for (size_t k = 0; k < 8; k++) {
+        out[idx + k] = carry + v[k];
+      }
+    }
+    carry += v[7];
+  }
+  for (; idx < n; idx++) {
+    T x = in[first + idx];
+    if constexpr (Exclusive) {
+      out[idx] = carry;
+      carry += x;
+    } else {
+      carry += x;
+      out[idx] = carry;
+    }
+  }
+  return carry;
+}
+
+// in[first] + ... + in[first + n - 1], with eight partial sums as in sum()
+template <typename T, typename E>
+T reduce(const E& in, size_t first, size_t n) {
+  T partial[8] = {};
+  size_t idx = 0;
+  for (; idx + 8 <= n; idx += 8) {
+    T block[8];
+    for (size_t k = 0; k < 8; k++) {
+      block[k] = in[first + idx + k];
+    }
+    for (size_t k = 0; k < 8; k++) {
+      partial[k] += block[k];
+    }
+  }
+  for (; idx < n; idx++) {
+    partial[0] += in[first + idx];
+  }
+  return ((partial[0] + partial[1]) + (partial[2] + partial[3])) +
+         ((partial[4] + partial[5]) + (partial[6] + partial[7]));
+}
+
+// prefix sums of in[0, n) into out on up to `threads` threads. Each thread
+// first sums its own range; the range totals are scanned into the carry
+// each range starts from, and each thread then scans its range (two passes
+// over the input, the second starting from the right carry)
+template <bool Exclusive, typename T, typename E>
+void prefix_sums(const E& in, T* out, size_t n, size_t threads) {
+  size_t len = range_length(n, threads);
+  if (len >= n) {
+    scan<Exclusive>(in, 0, out, n, T());
+    return;
+  }
+  std::vector<T> carry((n + len - 1) / len + 1, T());
+  parallel(n, len, [&](size_t first, size_t count) {
+    carry[first / len + 1] = reduce<T>(in, first, count);
+  });
+  for (size_t part = 1; part < carry.size(); part++) {
+    carry[part] += carry[part - 1];
+  }
+  parallel(n, len, [&](size_t first, size_t count) {
+    scan<Exclusive>(in, first, out + first, count, carry[first / len]);
+  });
+}
+
+// sums of the trailing windows of `w` elements of in[0, n) into out, i.e.
+// out[i] = in[i - w + 1] + ... + in[i] (fewer terms for i < w - 1), divided
+// by the number of terms if `average`. Prefix sums are restarted at every
+// block of w elements, and a window is the rest of the previous block plus
+// a prefix of the current one: each output is computed from sums of at most
+// w elements, so unlike a difference of prefix sums of the whole array its
+// rounding error does not grow along the array
+template <typename T, typename E>
+void window_sums(const E& in, T* out, size_t n, size_t w, bool average,
+                 size_t threads) {
+  size_t len = range_length(n, threads, w);
+  parallel(n, len, [&](size_t first, size_t count) {
+    // prefix sums of the previous block; a range other than the first
+    // recomputes those of the block before it
+    SArray<T> prev(w);
+    if (first >= w) {
+      scan<false>(in, first - w, prev.data(), w, T());
+    }
+    for (size_t b = first; b < first + count; b += w) {
+      size_t m = std::min(w, first + count - b);
+      T* p = out + b;
+      scan<false>(in, b, p, m, T());
+      if (b == 0) {
+        for (size_t k = 0; k < m; k++) {
+          prev[k] = p[k];
+          if (average) {
+            p[k] /= static_cast<T>(k + 1);
+          }
+        }
+        continue;
+      }
+      T total = prev[w - 1];
+      for (size_t k = 0; k < m; k++) {
+        T sum = p[k];
+        p[k] = sum + (total - prev[k]);
+        prev[k] = sum;
+      }
+      if (average) {
+        for (size_t k = 0; k < m; k++) {
+          p[k] /= static_cast<T>(w);
+        }
+      }
+    }
+  });
+}
+
+};  // namespace scan_impl
+
+// evaluate `a` and pass its elements to `compute(expr, out, n)`, which
+// fills the n elements of the result
+template <typename T, typename Rep, typename F>
+auto A_materialize(const Array<T, Rep>& a, F compute) {
+  using U = A_Compute_t<T>;
+  using Opt = remove_cvref_t<decltype(optimize(a.rep()))>;
+  const typename A_Traits<Opt>::ExprRef expr = optimize(a.rep());
+  A_Materialized<U> result(a.size());
+  compute(expr, result.data(), a.size());
+  return Array<U, A_Materialized<U>>(result);
+}
+
+// running sums of `a`: element i is a[0] + ... + a[i]. Large arrays are
+// scanned on `threads` threads
+template <typename T, typename Rep>
+auto inclusive_scan(const Array<T, Rep>& a, size_t threads = 1) {
+  return A_materialize(a, [threads](const auto& expr, auto* out, size_t n) {
+    scan_impl::prefix_sums<false>(expr, out, n, threads);
+  });
+}
+
+// running sums of `a` excluding the current element: element i is
+// a[0] + ... + a[i - 1], and element 0 is zero
+template <typename T, typename Rep>
+auto exclusive_scan(const Array<T, Rep>& a, size_t threads = 1) {
+  return A_materialize(a, [threads](const auto& expr, auto* out, size_t n) {
+    scan_impl::prefix_sums<true>(expr, out, n, threads);
+  });
+}
+
+// sums of the trailing windows of `w` elements of `a`: element i is
+// a[i - w + 1] + ... + a[i], and the first w - 1 elements sum the elements
+// so far
+template <typename T, typename Rep>
+auto moving_sum(const Array<T, Rep>& a, size_t w, size_t threads = 1) {
+  assert(w > 0);
+  return A_materialize(a, [=](const auto& expr, auto* out, size_t n) {
+    scan_impl::window_sums(expr, out, n, w, false, threads);
+  });
+}
+
+// means of the trailing windows of `w` elements of `a`; the first w - 1
+// elements average the elements so far (integer elements are averaged with
+// integer division)
+template <typename T, typename Rep>
+auto moving_average(const Array<T, Rep>& a, size_t w, size_t threads = 1) {
+  assert(w > 0);
+  return A_materialize(a, [=](const auto& expr, auto* out, size_t n) {
+    scan_impl::window_sums(expr, out, n, w, true, threads);
+  });
+}
+
+// bytes per chunk for evaluate_chunked(): half of a typical 256 KiB L2, so
+// the chunk stays cached while the sink consumes it and the operands stream
+// through the other half
+inline constexpr size_t A_ChunkBytes = 128 * 1024;
+
+// evaluate expression `a` without materializing the whole result: elements
+// are computed `chunk` at a time into one reused buffer, and each filled
+// chunk is handed to `sink(const T* data, size_t count)` in index order
+// (e.g. to write it to a file, checksum it or send it)
+template <typename T, typename Rep, typename Sink>
+void evaluate_chunked(const Array<T, Rep>& a, Sink&& sink,
+                      size_t chunk = A_ChunkBytes / sizeof(T)) {
+  chunk = std::max<size_t>(chunk, 1);
+  using Opt = remove_cvref_t<decltype(optimize(a.rep()))>;
+  const typename A_Traits<Opt>::ExprRef expr = optimize(a.rep());
+  size_t n = a.size();
+  if (n == 0) {
+    return;
+  }
+  SArray<T> buffer(std::min(chunk, n));
+  T* out = buffer.data();
+  for (size_t first = 0; first < n; first += chunk) {
+    size_t count = std::min(chunk, n - first);
+    for (size_t idx = 0; idx < count; idx++) {
+      out[idx] = expr[first + idx];
+    }
+    sink(static_cast<const T*>(out), count);
+  }
+}
+
+// view of the `n` elements of `a` starting at `first`
+template <typename T, typename Rep>
+auto slice(Array<T, Rep>& a, size_t first, size_t n) {
+  assert(first + n <= a.size());
+  return Array<T, A_Slice<T>>(A_Slice<T>(a.rep().data() + first, n));
+}
+
+// view of `n` elements of `a`, starting at `first`, `step` elements apart
+template <typename T, typename Rep>
+auto stride(Array<T, Rep>& a, size_t first, size_t n, size_t step) {
+  assert(n == 0 || first + (n - 1) * step < a.size());
+  return Array<T, A_Stride<T>>(A_Stride<T>(a.rep().data() + first, n, step));
+}
+
+// view of the elements of `a` at the positions listed in `indices`
+template <typename T, typename Rep>
+auto gather(Array<T, Rep>& a, const Array<size_t>& indices) {
+  return Array<T, A_Gather<T>>(
+      A_Gather<T>(a.rep().data(), indices.rep().data(), indices.size()));
+}
+
+// the `n` values start, start + 1, ..., computed inside the evaluation loop
+template <typename T = size_t>
+auto iota(size_t n, T start = T()) {
+  return Array<T, A_Iota<T>>(A_Iota<T>(start, n));
+}
+
+// `n` evenly spaced values from `first` to `last`
+template <typename T>
+auto linspace(T first, T last, size_t n) {
+  return Array<T, A_Linspace<T>>(A_Linspace<T>(first, last, n));
+}
+
+// `n` random values uniformly distributed in [0, 1); the same seed gives the
+// same values, and different seeds give independent sequences
+template <typename T = double>
+auto uniform(size_t n, uint64_t seed) {
+  return Array<T, A_Uniform<T>>(A_Uniform<T>(seed, n));
+}
+
+// `n` random values from the standard normal distribution
+template <typename T = double>
+auto normal(size_t n, uint64_t seed) {
+  return Array<T, A_Normal<T>>(A_Normal<T>(seed, n));
 }
 
 };  // namespace stl
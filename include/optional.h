@@ -0,0 +1,399 @@
+#ifndef OPTIONAL_H_
+#define OPTIONAL_H_
+
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <new>
+
+#include "memory.h"
+#include "type_traits.h"
+#include "utility.h"
+
+/*============================================================
+============================Optional==========================
+==============================================================*/
+
+// optional<T> holds a T or nothing. It normally marks the empty state with a
+// bool next to the T, which padding makes as large as T's alignment. A type
+// whose object representation has a pattern that no T value uses declares it
+// through optional_sentinel<T>, and the empty state is then that pattern in
+// the storage of the T, so that optional<T> is no larger than T
+
+namespace stl {
+
+// optional_sentinel<T>: with `enabled` true, `make_empty(storage)` stores the
+// sentinel in the storage of a T, which holds no live T at the time, and
+// `is_empty(storage)` tells the sentinel from any T value
+template <typename T>
+struct optional_sentinel {
+  static constexpr bool enabled = false;
+};
+
+// the sentinel of a pointer to an object aligned to more than one byte: all
+// bits set, which is neither null nor a multiple of the alignment. Pointers
+// to bytes, void and functions have no such pattern (MAP_FAILED and SIG_ERR
+// are all bits set), and keep the flag
+struct optional_pointer_sentinel {
+  static constexpr bool enabled = true;
+
+  static void make_empty(void* storage) noexcept {
+    uintptr_t bits = ~uintptr_t(0);
+    std::memcpy(storage, &bits, sizeof(bits));
+  }
+
+  static bool is_empty(const void* storage) noexcept {
+    uintptr_t bits;
+    std::memcpy(&bits, storage, sizeof(bits));
+    return bits == ~uintptr_t(0);
+  }
+};
+
+// pointers to incomplete types keep the flag too, since their alignment is
+// not known
+template <typename T>
+concept optional_aligned_object = is_object_v<T> && (alignof(T) > 1);
+
+template <typename T>
+  requires optional_aligned_object<T>
+struct optional_sentinel<T*> : optional_pointer_sentinel {};
+
+// a unique_ptr is its pointer
+template <typename T>
+  requires optional_aligned_object<remove_extent_t<T>>
+struct optional_sentinel<unique_ptr<T>> : optional_pointer_sentinel {
+  static_assert(sizeof(unique_ptr<T>) == sizeof(uintptr_t));
+};
+
+template <typename T>
+class optional;
+
+// is_optional_v<T>: whether T is a specialization of optional
+template <typename T>
+inline constexpr bool is_optional_v = false;
+
+template <typename T>
+inline constexpr bool is_optional_v<optional<T>> = true;
+
+class bad_optional_access : public std::exception {
+ public:
+  const char* what() const noexcept override { return "bad optional access"; }
+};
+
+// nullopt_t
+struct nullopt_t {
+  constexpr explicit nullopt_t(int) {}
+};
+
+inline constexpr nullopt_t nullopt{0};
+
+// storage of a T, with a flag for whether it holds one
+template <typename T, bool = optional_sentinel<T>::enabled>
+struct optional_storage {
+  bool has_value() const noexcept { return engaged; }
+  void set_engaged() noexcept { engaged = true; }
+  void set_empty() noexcept { engaged = false; }
+
+  alignas(T) unsigned char bytes[sizeof(T)];
+  bool engaged = false;
+};
+
+// storage of a T, which holds the sentinel when it holds no T
+template <typename T>
+struct optional_storage<T, true> {
+  optional_storage() noexcept { set_empty(); }
+
+  bool has_value() const noexcept {
+    return !optional_sentinel<T>::is_empty(bytes);
+  }
+  void set_engaged() noexcept {}
+  void set_empty() noexcept { optional_sentinel<T>::make_empty(bytes); }
+
+  alignas(T) unsigned char bytes[sizeof(T)];
+};
+
+template <typename T>
+class optional {
+  static_assert(!is_reference_v<T>, "no optional of a reference");
+
+ public:
+  /*====================Member types====================*/
+  using value_type = T;
+
+  /*====================Member functions====================*/
+
+  /**
+   * Constructs an optional that holds no value
+   */
+  optional() noexcept = default;
+  optional(nullopt_t) noexcept {}
+
+  /**
+   * Copy constructor: a bitwise copy when T can be copied that way. Deleted
+   * unless T is copy constructible
+   */
+  optional(const optional&) requires is_trivially_copy_constructible_v<T> =
+      default;
+
+  optional(const optional& other) requires(
+      is_copy_constructible_v<T> && !is_trivially_copy_constructible_v<T>) {
+    if (other.has_value()) {
+      construct(*other);
+    }
+  }
+
+  /**
+   * Move constructor: a bitwise copy when T can be moved that way. The
+   * value of `other`, if any, is moved from, and `other` still holds it.
+   * Does not throw unless moving T does, so that containers of optionals
+   * move them when they reallocate
+   */
+  optional(optional&&) requires is_trivially_move_constructible_v<T> =
+      default;
+
+  optional(optional&& other) noexcept(is_nothrow_move_constructible_v<T>)
+    requires(is_move_constructible_v<T> &&
+             !is_trivially_move_constructible_v<T>)
+  {
+    if (other.has_value()) {
+      construct(stl::move(*other));
+    }
+  }
+
+  /**
+   * Constructs an optional that holds the value initialized from `value`.
+   * Explicit unless `value` converts to T implicitly. Another optional is
+   * never the value, so optional<bool> is not constructed from optional<int>
+   * @param value the value to hold
+   */
+  template <typename U = T,
+            typename = enable_if_t<
+                !is_optional_v<remove_cvref_t<U>> &&
+                !is_same_v<remove_cvref_t<U>, in_place_t> &&
+                !is_same_v<remove_cvref_t<U>, nullopt_t> &&
+                is_constructible_v<T, U&&>>>
+  explicit(!is_convertible_v<U&&, T>) optional(U&& value) {
+    construct(stl::forward<U>(value));
+  }
+
+  /**
+   * Constructs the value in place
+   * @param args arguments of T's constructor
+   */
+  template <typename... Args>
+  explicit optional(in_place_t, Args&&... args) {
+    construct(stl::forward<Args>(args)...);
+  }
+
+  ~optional() requires is_trivially_destructible_v<T> = default;
+  ~optional() { reset(); }
+
+  optional& operator=(const optional&) requires(
+      is_trivially_copy_constructible_v<T> &&
+      is_trivially_copy_assignable_v<T> &&
+      is_trivially_destructible_v<T>) = default;
+
+  optional& operator=(const optional& other) requires(
+      is_copy_constructible_v<T> && is_copy_assignable_v<T> &&
+      !(is_trivially_copy_constructible_v<T> &&
+        is_trivially_copy_assignable_v<T> &&
+        is_trivially_destructible_v<T>)) {
+    if (!other.has_value()) {
+      reset();
+    } else if (has_value()) {
+      **this = *other;
+    } else {
+      construct(*other);
+    }
+    return *this;
+  }
+
+  optional& operator=(optional&&) requires(
+      is_trivially_move_constructible_v<T> &&
+      is_trivially_move_assignable_v<T> &&
+      is_trivially_destructible_v<T>) = default;
+
+  optional& operator=(optional&& other) noexcept(
+      is_nothrow_move_constructible_v<T> && is_nothrow_move_assignable_v<T>)
+    requires(is_move_constructible_v<T> && is_move_assignable_v<T> &&
+             !(is_trivially_move_constructible_v<T> &&
+               is_trivially_move_assignable_v<T> &&
+               is_trivially_destructible_v<T>))
+  {
+    if (!other.has_value()) {
+      reset();
+    } else if (has_value()) {
+      **this = stl::move(*other);
+    } else {
+      construct(stl::move(*other));
+    }
+    return *this;
+  }
+
+  /**
+   * Destroys the value held, if any
+   * @return *this
+   */
+  optional& operator=(nullopt_t) noexcept {
+    reset();
+    return *this;
+  }
+
+  /**
+   * Assigns `value` to the value held, or constructs the value from it if
+   * none is held
+   * @param value the new value
+   * @return *this
+   */
+  template <typename U = T,
+            typename = enable_if_t<!is_optional_v<remove_cvref_t<U>> &&
+                                   !is_same_v<remove_cvref_t<U>, nullopt_t> &&
+                                   is_constructible_v<T, U&&> &&
+                                   is_assignable_v<T&, U&&>>>
+  optional& operator=(U&& value) {
+    if (has_value()) {
+      **this = stl::forward<U>(value);
+    } else {
+      construct(stl::forward<U>(value));
+    }
+    return *this;
+  }
+
+  /*==========Observers==========*/
+
+  /**
+   * Checks whether the optional holds a value
+   * @return true if it holds a value, false otherwise
+   */
+  bool has_value() const noexcept { return storage_.has_value(); }
+  explicit operator bool() const noexcept { return has_value(); }
+
+  /**
+   * Returns the value held. The behavior is undefined if there is none
+   * @return reference to the value held
+   */
+  T& operator*() & noexcept { return *ptr(); }
+  const T& operator*() const& noexcept { return *ptr(); }
+  T&& operator*() && noexcept { return stl::move(*ptr()); }
+  const T&& operator*() const&& noexcept { return stl::move(*ptr()); }
+
+  T* operator->() noexcept { return ptr(); }
+  const T* operator->() const noexcept { return ptr(); }
+
+  /**
+   * Returns the value held, or throws bad_optional_access if there is none
+   * @return reference to the value held
+   */
+  T& value() & { return check(), **this; }
+  const T& value() const& { return check(), **this; }
+  T&& value() && { return check(), stl::move(**this); }
+  const T&& value() const&& { return check(), stl::move(**this); }
+
+  /**
+   * Returns the value held, or `default_value` if there is none
+   * @param default_value the value returned if none is held
+   * @return copy of the value held, or `default_value`
+   */
+  template <typename U>
+  T value_or(U&& default_value) const& {
+    return has_value() ? **this
+                       : static_cast<T>(stl::forward<U>(default_value));
+  }
+
+  template <typename U>
+  T value_or(U&& default_value) && {
+    return has_value() ? stl::move(**this)
+                       : static_cast<T>(stl::forward<U>(default_value));
+  }
+
+  /*==========Modifiers==========*/
+
+  /**
+   * Destroys the value held, if any, and constructs a new value in place
+   * @param args arguments of T's constructor
+   * @return reference to the new value
+   */
+  template <typename... Args>
+  T& emplace(Args&&... args) {
+    reset();
+    construct(stl::forward<Args>(args)...);
+    return **this;
+  }
+
+  /**
+   * Destroys the value held, if any
+   */
+  void reset() noexcept {
+    if (has_value()) {
+      std::destroy_at(ptr());
+      storage_.set_empty();
+    }
+  }
+
+ private:
+  T* ptr() noexcept {
+    return std::launder(reinterpret_cast<T*>(storage_.bytes));
+  }
+  const T* ptr() const noexcept {
+    return std::launder(reinterpret_cast<const T*>(storage_.bytes));
+  }
+
+  template <typename... Args>
+  void construct(Args&&... args) {
+    if constexpr (optional_sentinel<T>::enabled &&
+                  !is_nothrow_constructible_v<T, Args&&...>) {
+      // a constructor that throws may have overwritten the sentinel
+      try {
+        ::new (static_cast<void*>(storage_.bytes))
+            T(stl::forward<Args>(args)...);
+      } catch (...) {
+        storage_.set_empty();
+        throw;
+      }
+    } else {
+      ::new (static_cast<void*>(storage_.bytes))
+          T(stl::forward<Args>(args)...);
+      storage_.set_engaged();
+    }
+  }
+
+  void check() const {
+    if (!has_value()) {
+      throw bad_optional_access();
+    }
+  }
+
+  optional_storage<T> storage_;
+};
+
+/*====================Non-member functions====================*/
+
+// make_optional
+template <typename T>
+optional<decay_t<T>> make_optional(T&& value) {
+  return optional<decay_t<T>>(stl::forward<T>(value));
+}
+
+template <typename T, typename... Args>
+optional<T> make_optional(Args&&... args) {
+  return optional<T>(in_place, stl::forward<Args>(args)...);
+}
+
+// operator==: equal when both hold equal values or both hold none
+template <typename T, typename U>
+bool operator==(const optional<T>& lhs, const optional<U>& rhs) {
+  if (lhs.has_value() != rhs.has_value()) {
+    return false;
+  }
+  return !lhs.has_value() || *lhs == *rhs;
+}
+
+template <typename T>
+bool operator==(const optional<T>& opt, nullopt_t) noexcept {
+  return !opt.has_value();
+}
+
+};  // namespace stl
+
+#endif  // OPTIONAL_H_
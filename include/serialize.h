@@ -0,0 +1,340 @@
+#ifndef SERIALIZE_H_
+#define SERIALIZE_H_
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+
+#include "array.h"
+#include "tuple.h"
+#include "type_traits.h"
+#include "vector.h"
+
+/*============================================================
+=========================Serialization========================
+==============================================================*/
+
+// Binary encoding of tuples, arrays and vectors in native byte order:
+// - a value with no padding bytes (see serial_bulk: a scalar, a trivially
+//   copyable class whose bytes are all part of its value, or an array or
+//   tuple of those with no padding between them) is its sizeof(T) bytes,
+//   copied with one memcpy. Padding bytes are indeterminate, so they are
+//   never written, and equal values always have the same encoding;
+// - an array of other types is its elements one after the other;
+// - a vector is its size as a uint64_t, then its elements. The elements of a
+//   vector of serial_bulk type are one memcpy, preceded by padding to their
+//   alignment (counted from the start of the buffer), so that a reader can
+//   return a view of them in place;
+// - a tuple of other types is its elements one after the other.
+
+namespace stl {
+
+class binary_writer;
+class binary_reader;
+
+// serial_bulk<T>: whether T is encoded as a copy of its bytes. A floating
+// point type has two representations of zero, so it has no unique object
+// representation, but it has no padding either, and scalars always qualify
+template <typename T>
+struct serial_bulk
+    : bool_constant<is_scalar_v<T> ||
+                    (is_trivially_copyable_v<T> &&
+                     has_unique_object_representations_v<T>)> {};
+
+template <typename T, size_t N>
+struct serial_bulk<array<T, N>>
+    : bool_constant<serial_bulk<T>::value &&
+                    sizeof(array<T, N>) == N * sizeof(T)> {};
+
+template <typename... Types>
+struct serial_bulk<tuple<Types...>>
+    : bool_constant<is_trivially_copyable_v<tuple<Types...>> &&
+                    (serial_bulk<Types>::value && ...) &&
+                    sizeof(tuple<Types...>) == (sizeof(Types) + ... + 0)> {};
+
+template <typename T>
+inline constexpr bool serial_bulk_v = serial_bulk<T>::value;
+
+template <typename T>
+void serialize(binary_writer& w, const T& value);
+template <typename T, size_t N>
+void serialize(binary_writer& w, const array<T, N>& a);
+template <typename T, typename Allocator>
+void serialize(binary_writer& w, const vector<T, Allocator>& v);
+template <typename... Types>
+void serialize(binary_writer& w, const tuple<Types...>& t);
+
+template <typename T>
+void deserialize(binary_reader& r, T& value);
+template <typename T, size_t N>
+void deserialize(binary_reader& r, array<T, N>& a);
+template <typename T, typename Allocator>
+void deserialize(binary_reader& r, vector<T, Allocator>& v);
+template <typename... Types>
+void deserialize(binary_reader& r, tuple<Types...>& t);
+
+// binary_writer: appends encoded values to a growing buffer
+class binary_writer {
+ public:
+  /**
+   * Appends the encoding of `value`
+   * @param value the value to encode
+   */
+  template <typename T>
+  void write(const T& value) {
+    serialize(*this, value);
+  }
+
+  /**
+   * Appends `size` bytes from `src`
+   */
+  void write_bytes(const void* src, size_t size) {
+    size_t pos = buffer_.size();
+    buffer_.resize(pos + size);
+    std::memcpy(buffer_.data() + pos, src, size);
+  }
+
+  /**
+   * Appends zero bytes up to the next multiple of `alignment`
+   */
+  void align(size_t alignment) {
+    buffer_.resize((buffer_.size() + alignment - 1) / alignment * alignment,
+                   0);
+  }
+
+  /**
+   * Returns the bytes written so far
+   */
+  const vector<unsigned char>& buffer() const { return buffer_; }
+
+ private:
+  vector<unsigned char> buffer_;
+};
+
+// binary_reader: decodes values from a buffer it does not own, in the order
+// they were written
+class binary_reader {
+ public:
+  binary_reader(const unsigned char* data, size_t size)
+      : data_(data), size_(size) {}
+
+  explicit binary_reader(const vector<unsigned char>& buffer)
+      : binary_reader(buffer.data(), buffer.size()) {}
+
+  /**
+   * Decodes a copy of the next value
+   * @return the decoded value
+   */
+  template <typename T>
+  T read() {
+    T value;
+    deserialize(*this, value);
+    return value;
+  }
+
+  /**
+   * Decodes the next value without copying the elements of vectors of
+   * serial_bulk type: see serial_view. The views point into the
+   * buffer and are valid as long as it is
+   * @return the decoded value, with views in place of such vectors
+   */
+  template <typename T>
+  auto view();
+
+  /**
+   * Copies the next `size` bytes to `dst`
+   */
+  void read_bytes(void* dst, size_t size) {
+    std::memcpy(dst, next(size), size);
+  }
+
+  /**
+   * Returns a pointer to the next `size` bytes and skips them
+   */
+  const unsigned char* next(size_t size) {
+    if (size > size_ - pos_) {
+      throw std::out_of_range("read past the end of the buffer");
+    }
+    const unsigned char* p = data_ + pos_;
+    pos_ += size;
+    return p;
+  }
+
+  /**
+   * Throws std::out_of_range unless `count` elements of at least
+   * `element_size` bytes each fit in the bytes not read yet. Checked before
+   * computing the byte count, which a corrupt `count` would wrap around
+   */
+  void check_count(uint64_t count, size_t element_size) const {
+    if (count > remaining() / element_size) {
+      throw std::out_of_range("element count past the end of the buffer");
+    }
+  }
+
+  /**
+   * Skips the padding up to the next multiple of `alignment`
+   */
+  void align(size_t alignment) {
+    next((pos_ + alignment - 1) / alignment * alignment - pos_);
+  }
+
+  /**
+   * Returns the number of bytes not read yet
+   */
+  size_t remaining() const { return size_ - pos_; }
+
+ private:
+  const unsigned char* data_;
+  size_t size_;
+  size_t pos_ = 0;
+};
+
+/*====================Encoding====================*/
+
+template <typename T>
+void serialize(binary_writer& w, const T& value) {
+  static_assert(serial_bulk_v<T>,
+                "no encoding for a type that is not trivially copyable or "
+                "has padding bytes; encode its members as a tuple");
+  w.write_bytes(&value, sizeof(T));
+}
+
+template <typename T, size_t N>
+void serialize(binary_writer& w, const array<T, N>& a) {
+  if constexpr (serial_bulk_v<T>) {
+    w.write_bytes(a.data(), sizeof(T) * N);
+  } else {
+    for (const T& e : a) {
+      serialize(w, e);
+    }
+  }
+}
+
+template <typename T, typename Allocator>
+void serialize(binary_writer& w, const vector<T, Allocator>& v) {
+  serialize(w, uint64_t(v.size()));
+  if constexpr (serial_bulk_v<T>) {
+    w.align(alignof(T));
+    w.write_bytes(v.data(), sizeof(T) * v.size());
+  } else {
+    for (const T& e : v) {
+      serialize(w, e);
+    }
+  }
+}
+
+template <typename... Types>
+void serialize(binary_writer& w, const tuple<Types...>& t) {
+  if constexpr (serial_bulk_v<tuple<Types...>>) {
+    w.write_bytes(&t, sizeof(t));
+  } else {
+    tuple_for_each([&w](const auto& e) { serialize(w, e); }, t);
+  }
+}
+
+/*====================Decoding====================*/
+
+template <typename T>
+void deserialize(binary_reader& r, T& value) {
+  static_assert(serial_bulk_v<T>,
+                "no encoding for a type that is not trivially copyable or "
+                "has padding bytes; encode its members as a tuple");
+  r.read_bytes(&value, sizeof(T));
+}
+
+template <typename T, size_t N>
+void deserialize(binary_reader& r, array<T, N>& a) {
+  if constexpr (serial_bulk_v<T>) {
+    r.read_bytes(a.data(), sizeof(T) * N);
+  } else {
+    for (T& e : a) {
+      deserialize(r, e);
+    }
+  }
+}
+
+template <typename T, typename Allocator>
+void deserialize(binary_reader& r, vector<T, Allocator>& v) {
+  uint64_t size = r.read<uint64_t>();
+  if constexpr (serial_bulk_v<T>) {
+    r.align(alignof(T));
+    // checks the size against the buffer before allocating for it
+    r.check_count(size, sizeof(T));
+    const unsigned char* src = r.next(sizeof(T) * size);
+    v.resize(size);
+    std::memcpy(v.data(), src, sizeof(T) * size);
+  } else {
+    // every element takes at least one byte
+    r.check_count(size, 1);
+    v.resize(size);
+    for (T& e : v) {
+      deserialize(r, e);
+    }
+  }
+}
+
+template <typename... Types>
+void deserialize(binary_reader& r, tuple<Types...>& t) {
+  if constexpr (serial_bulk_v<tuple<Types...>>) {
+    r.read_bytes(&t, sizeof(t));
+  } else {
+    tuple_for_each([&r](auto& e) { deserialize(r, e); }, t);
+  }
+}
+
+/*====================Zero-copy decoding====================*/
+
+// serial_view<T>::type is what binary_reader::view<T> returns: a
+// std::span<const E> into the buffer for a vector of serial_bulk E, a
+// tuple of views for a tuple, and a copy of the value otherwise
+template <typename T>
+struct serial_view {
+  using type = T;
+
+  static type read(binary_reader& r) { return r.read<T>(); }
+};
+
+template <typename T, typename Allocator>
+struct serial_view<vector<T, Allocator>> {
+  using type = conditional_t<serial_bulk_v<T>, std::span<const T>,
+                             vector<T, Allocator>>;
+
+  static type read(binary_reader& r) {
+    if constexpr (serial_bulk_v<T>) {
+      uint64_t size = r.read<uint64_t>();
+      r.align(alignof(T));
+      r.check_count(size, sizeof(T));
+      const unsigned char* src = r.next(sizeof(T) * size);
+      if (reinterpret_cast<uintptr_t>(src) % alignof(T) != 0) {
+        throw std::invalid_argument("buffer not aligned for a view");
+      }
+      return type(reinterpret_cast<const T*>(src), size);
+    } else {
+      return r.read<vector<T, Allocator>>();
+    }
+  }
+};
+
+template <typename... Types>
+struct serial_view<tuple<Types...>> {
+  using type = tuple<typename serial_view<Types>::type...>;
+
+  static type read(binary_reader& r) {
+    if constexpr (serial_bulk_v<tuple<Types...>>) {
+      return r.read<tuple<Types...>>();
+    } else {
+      // braced initialization reads the elements in order
+      return type{serial_view<Types>::read(r)...};
+    }
+  }
+};
+
+template <typename T>
+auto binary_reader::view() {
+  return serial_view<T>::read(*this);
+}
+
+};  // namespace stl
+
+#endif  // SERIALIZE_H_
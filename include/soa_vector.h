@@ -0,0 +1,309 @@
+#ifndef SOA_VECTOR_H_
+#define SOA_VECTOR_H_
+
+#include <span>
+#include <utility>
+
+#include "tuple.h"
+#include "type_traits.h"
+#include "typelist.h"
+#include "vector.h"
+
+/*============================================================
+===========================SoA Vector=========================
+==============================================================*/
+
+// soa_vector<tuple<Types...>> holds a sequence of tuple<Types...> records as
+// a structure of arrays: field N of every record is kept in its own
+// contiguous column, a stl::vector of the field's type. A scan over a few
+// fields then reads only the columns of those fields, instead of loading
+// whole records into the cache and using a small part of each line.
+//
+// The modifiers that add records extend the columns one after another. If
+// constructing a field throws, the columns already extended are shrunk back,
+// so that every column keeps the same size and the container holds the
+// records it held before the call
+
+namespace stl {
+
+template <typename Record>
+class soa_vector;
+
+// soa_row: proxy for one record of a soa_vector, which is not stored as a
+// tuple anywhere. Soa is `const soa_vector<...>` for a read-only row
+template <typename Soa>
+class soa_row {
+ public:
+  using value_type = typename remove_const_t<Soa>::value_type;
+
+  soa_row(Soa& soa, size_t pos) : soa_(&soa), pos_(pos) {}
+
+  /**
+   * Returns a reference to field N of the record
+   * @return reference into column N
+   */
+  template <size_t N>
+  decltype(auto) get() const {
+    return soa_->template column<N>()[pos_];
+  }
+
+  /**
+   * Copies the record out of the columns
+   * @return the record as a tuple
+   */
+  operator value_type() const {
+    return to_value(std::make_index_sequence<remove_const_t<Soa>::fields>());
+  }
+
+  /**
+   * Writes the fields of `record` into the columns
+   * @param record the new value of the record
+   * @return this row
+   */
+  const soa_row& operator=(const value_type& record) const {
+    assign(record, std::make_index_sequence<remove_const_t<Soa>::fields>());
+    return *this;
+  }
+
+  const soa_row& operator=(const soa_row& other) const {
+    return *this = value_type(other);
+  }
+
+ private:
+  template <size_t... I>
+  value_type to_value(std::index_sequence<I...>) const {
+    return value_type(get<I>()...);
+  }
+
+  template <size_t... I>
+  void assign(const value_type& record, std::index_sequence<I...>) const {
+    ((get<I>() = stl::get<I>(record)), ...);
+  }
+
+  Soa* soa_;
+  size_t pos_;
+};
+
+/**
+ * Returns a reference to field N of the record `row`
+ * @param row proxy for the record
+ * @return reference into column N
+ */
+template <size_t N, typename Soa>
+decltype(auto) get(const soa_row<Soa>& row) {
+  return row.template get<N>();
+}
+
+// soa_iterator: iterates over the rows of a soa_vector
+template <typename Soa>
+class soa_iterator {
+ public:
+  soa_iterator(Soa& soa, size_t pos) : soa_(&soa), pos_(pos) {}
+
+  soa_row<Soa> operator*() const { return soa_row<Soa>(*soa_, pos_); }
+
+  soa_iterator& operator++() {
+    pos_++;
+    return *this;
+  }
+
+  bool operator==(const soa_iterator& other) const {
+    return pos_ == other.pos_;
+  }
+  bool operator!=(const soa_iterator& other) const { return !(*this == other); }
+
+ private:
+  Soa* soa_;
+  size_t pos_;
+};
+
+template <typename... Types>
+class soa_vector<tuple<Types...>> {
+  static_assert(sizeof...(Types) != 0, "a record must have a field");
+
+ public:
+  /*====================Member types====================*/
+  using value_type = tuple<Types...>;
+  using size_type = size_t;
+  using reference = soa_row<soa_vector>;
+  using const_reference = soa_row<const soa_vector>;
+  using iterator = soa_iterator<soa_vector>;
+  using const_iterator = soa_iterator<const soa_vector>;
+
+  // the type of field N
+  template <size_t N>
+  using field_type = nth_element_t<typelist<Types...>, N>;
+
+  // the number of fields of a record
+  static constexpr size_t fields = sizeof...(Types);
+
+  /*====================Member functions====================*/
+
+  soa_vector() = default;
+
+  /**
+   * Constructs the container with `count` default-constructed records
+   * @param count number of records
+   */
+  explicit soa_vector(size_type count) { resize(count); }
+
+  /*==========Element access==========*/
+
+  /**
+   * Returns a proxy for the record at position `pos`
+   * @param pos position of the record
+   * @return row proxy whose fields refer into the columns
+   */
+  reference operator[](size_type pos) { return reference(*this, pos); }
+  const_reference operator[](size_type pos) const {
+    return const_reference(*this, pos);
+  }
+
+  /**
+   * Returns the contiguous column of field N of all records
+   * @return span over the values of field N, one per record
+   */
+  template <size_t N>
+  std::span<field_type<N>> column() {
+    return std::span<field_type<N>>(get<N>(columns_).data(), size());
+  }
+
+  template <size_t N>
+  std::span<const field_type<N>> column() const {
+    return std::span<const field_type<N>>(get<N>(columns_).data(), size());
+  }
+
+  /*==========Iterators==========*/
+
+  iterator begin() { return iterator(*this, 0); }
+  const_iterator begin() const { return const_iterator(*this, 0); }
+
+  iterator end() { return iterator(*this, size()); }
+  const_iterator end() const { return const_iterator(*this, size()); }
+
+  /*==========Capacity==========*/
+
+  /**
+   * Checks whether the container has no records
+   * @return true if the container is empty, false otherwise
+   */
+  bool empty() const noexcept { return size() == 0; }
+
+  /**
+   * Returns the number of records in the container
+   * @return the number of records
+   */
+  size_type size() const noexcept { return get<0>(columns_).size(); }
+
+  /**
+   * Reserves room for `new_cap` records in every column
+   * @param new_cap new capacity of the columns
+   */
+  void reserve(size_type new_cap) {
+    for_each_column([new_cap](auto& c) { c.reserve(new_cap); });
+  }
+
+  /*==========Modifiers==========*/
+
+  /**
+   * Erases all records from the container
+   */
+  void clear() noexcept {
+    for_each_column([](auto& c) { c.clear(); });
+  }
+
+  /**
+   * Appends the record `record`, one field to each column
+   * @param record the record to append
+   */
+  void push_back(const value_type& record) {
+    grow_columns(
+        [&] { push_back_impl(record, std::index_sequence_for<Types...>()); });
+  }
+
+  /**
+   * Appends a record from one value per field
+   * @param args values of the fields, in field order
+   * @return proxy for the appended record
+   */
+  template <typename... Args,
+            typename = enable_if_t<sizeof...(Args) == sizeof...(Types)>>
+  reference emplace_back(Args&&... args) {
+    grow_columns([&] {
+      emplace_back_impl(std::index_sequence_for<Types...>(),
+                        std::forward<Args>(args)...);
+    });
+    return (*this)[size() - 1];
+  }
+
+  /**
+   * Removes the last record. Calling this function on an empty container
+   * causes undefined behavior.
+   */
+  void pop_back() {
+    for_each_column([](auto& c) { c.pop_back(); });
+  }
+
+  /**
+   * Resizes the container to contain `count` records
+   * @param count the new size of the container
+   */
+  void resize(size_type count) {
+    if (count <= size()) {
+      shrink_columns(count);
+    } else {
+      grow_columns(
+          [&] { for_each_column([count](auto& c) { c.resize(count); }); });
+    }
+  }
+
+ private:
+  template <typename F>
+  void for_each_column(F&& f) {
+    for_each_column_impl(f, std::index_sequence_for<Types...>());
+  }
+
+  template <typename F, size_t... I>
+  void for_each_column_impl(F& f, std::index_sequence<I...>) {
+    (f(get<I>(columns_)), ...);
+  }
+
+  // calls `extend`, which extends the columns one after another. A column
+  // whose extension throws keeps its size, and the columns extended before it
+  // are shrunk back to that size
+  template <typename F>
+  void grow_columns(F&& extend) {
+    size_type old_size = size();
+    try {
+      extend();
+    } catch (...) {
+      shrink_columns(old_size);
+      throw;
+    }
+  }
+
+  // removes the records from `count` on, without constructing anything
+  void shrink_columns(size_type count) noexcept {
+    for_each_column([count](auto& c) {
+      while (c.size() > count) {
+        c.pop_back();
+      }
+    });
+  }
+
+  template <size_t... I>
+  void push_back_impl(const value_type& record, std::index_sequence<I...>) {
+    (get<I>(columns_).push_back(get<I>(record)), ...);
+  }
+
+  template <size_t... I, typename... Args>
+  void emplace_back_impl(std::index_sequence<I...>, Args&&... args) {
+    (get<I>(columns_).emplace_back(std::forward<Args>(args)), ...);
+  }
+
+  tuple<vector<Types>...> columns_;
+};
+
+};  // namespace stl
+
+#endif  // SOA_VECTOR_H_
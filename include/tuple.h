@@ -2,42 +2,178 @@
 #define TUPLE_H_
 
 #include <iostream>
+#include <utility>
+
 #include "type_traits.h"
 #include "typelist.h"
 
 namespace stl {
 
-template <typename... Types>
-class tuple;
+// Elements are stored flat: tuple<T0, ..., Tn> derives from one
+// tuple_leaf<I, TI> per element, so that accessing element N is a single
+// derived-to-base conversion instead of N levels of recursion through nested
+// head/tail tuples. The index in each leaf keeps leaves of equal element
+// types distinct
+
+// storage of element I of type T. An empty element, such as a stateless
+// allocator or deleter, takes no space of its own. It is a member rather than
+// a base, so that the leaves of a nested tuple never become bases of the
+// outer one
+template <size_t I, typename T>
+struct tuple_leaf {
+  tuple_leaf() : value(){};
+
+  template <typename V>
+  tuple_leaf(V&& v) : value(std::forward<V>(v)){};
+
+  T& get() { return value; }
+  const T& get() const { return value; }
+
+  [[no_unique_address]] T value;
+};
+
+// element I of a tuple: the element type is deduced from the one base
+// tuple_leaf<I, T>, without instantiating anything per preceding element
+template <size_t I, typename T>
+T& tuple_leaf_get(tuple_leaf<I, T>& leaf) {
+  return leaf.get();
+}
+
+template <size_t I, typename T>
+const T& tuple_leaf_get(const tuple_leaf<I, T>& leaf) {
+  return leaf.get();
+}
+
+template <size_t I, typename T>
+T&& tuple_leaf_get(tuple_leaf<I, T>&& leaf) {
+  return static_cast<T&&>(leaf.get());
+}
 
-template <typename Head, typename... Tail>
-class tuple<Head, Tail...> {
+// the element of type T of a tuple: the index is deduced from the base
+// tuple_leaf<I, T>, which fails unless exactly one element has type T
+template <typename T, size_t I>
+T& tuple_type_get(tuple_leaf<I, T>& leaf) {
+  return leaf.get();
+}
+
+template <typename T, size_t I>
+const T& tuple_type_get(const tuple_leaf<I, T>& leaf) {
+  return leaf.get();
+}
+
+template <typename T, size_t I>
+T&& tuple_type_get(tuple_leaf<I, T>&& leaf) {
+  return static_cast<T&&>(leaf.get());
+}
+
+// tag of the tuple_impl constructor from element values, which keeps it
+// from competing with the copy and move constructors
+struct tuple_elements_tag {};
+
+template <typename Indices, typename... Types>
+class tuple_impl;
+
+template <size_t... I, typename... Types>
+class tuple_impl<std::index_sequence<I...>, Types...>
+    : public tuple_leaf<I, Types>... {
  public:
-  template <typename VHead, typename... VTail,
-            typename = enable_if_t<sizeof...(VTail) == sizeof...(Tail)>>
-  tuple(VHead&& vhead, VTail&&... vtail)
-      : head(std::forward<VHead>(vhead)), tail(std::forward<VTail>(vtail)...){};
+  tuple_impl() = default;
 
-  template <typename VHead, typename... VTail,
-            typename = enable_if_t<sizeof...(VTail) == sizeof...(Tail)>>
-  tuple(const tuple<VHead, VTail...>& other)
-      : head(other.get_head()), tail(other.get_tail()){};
+  template <typename... VTypes>
+  tuple_impl(tuple_elements_tag, VTypes&&... v)
+      : tuple_leaf<I, Types>(std::forward<VTypes>(v))...{};
+};
 
-  Head& get_head() { return head; }
+template <typename... Types>
+class tuple
+    : public tuple_impl<std::make_index_sequence<sizeof...(Types)>, Types...> {
+  using base = tuple_impl<std::make_index_sequence<sizeof...(Types)>, Types...>;
 
-  const Head& get_head() const { return head; }
+ public:
+  tuple() = default;
 
-  tuple<Tail...>& get_tail() { return tail; }
+  template <typename... VTypes,
+            typename = enable_if_t<sizeof...(VTypes) == sizeof...(Types) &&
+                                   sizeof...(VTypes) != 0>,
+            typename = enable_if_t<!(sizeof...(VTypes) == 1 &&
+                                     (is_same_v<decay_t<VTypes>, tuple> &&
+                                      ...))>>
+  tuple(VTypes&&... v)
+      : base(tuple_elements_tag(), std::forward<VTypes>(v)...){};
 
-  const tuple<Tail...>& get_tail() const { return tail; }
+  template <typename... VTypes,
+            typename = enable_if_t<sizeof...(VTypes) == sizeof...(Types)>>
+  tuple(const tuple<VTypes...>& other)
+      : tuple(other, std::make_index_sequence<sizeof...(Types)>()){};
 
  private:
-  Head head;
-  tuple<Tail...> tail;
+  template <typename... VTypes, size_t... I>
+  tuple(const tuple<VTypes...>& other, std::index_sequence<I...>)
+      : base(tuple_elements_tag(), tuple_leaf_get<I>(other)...){};
 };
 
-template <>
-class tuple<> {};
+// packed_tuple<Types...> holds the same elements as tuple<Types...>, but lays
+// them out by decreasing alignment, which leaves no padding between elements.
+// Element I is still found by its original index: the leaves are sorted
+// together with their indices, so tuple_leaf<I, T> keeps index I wherever it
+// ends up in the layout
+
+// element type T paired with its index I in the packed_tuple
+template <size_t I, typename T>
+struct packed_element {};
+
+// elements of larger alignment go first; sort_t is stable, so elements of
+// equal alignment keep their order
+template <typename E1, typename E2>
+struct packed_before;
+
+template <size_t I1, typename T1, size_t I2, typename T2>
+struct packed_before<packed_element<I1, T1>, packed_element<I2, T2>>
+    : greater_alignment<T1, T2> {};
+
+template <typename Indices, typename... Types>
+struct packed_layout;
+
+template <size_t... I, typename... Types>
+struct packed_layout<std::index_sequence<I...>, Types...>
+    : sort<typelist<packed_element<I, Types>...>, packed_before> {};
+
+template <typename Layout>
+class packed_impl;
+
+template <size_t... I, typename... Types>
+class packed_impl<typelist<packed_element<I, Types>...>>
+    : public tuple_leaf<I, Types>... {
+ public:
+  packed_impl() = default;
+
+  // `elems` is a tuple of references to the element values in their
+  // original order; each leaf picks out its own by index
+  template <typename Elems>
+  packed_impl(tuple_elements_tag, Elems&& elems)
+      : tuple_leaf<I, Types>(tuple_leaf_get<I>(std::move(elems)))...{};
+};
+
+template <typename... Types>
+class packed_tuple
+    : public packed_impl<typename packed_layout<
+          std::make_index_sequence<sizeof...(Types)>, Types...>::type> {
+  using base = packed_impl<typename packed_layout<
+      std::make_index_sequence<sizeof...(Types)>, Types...>::type>;
+
+ public:
+  packed_tuple() = default;
+
+  template <typename... VTypes,
+            typename = enable_if_t<sizeof...(VTypes) == sizeof...(Types) &&
+                                   sizeof...(VTypes) != 0>,
+            typename = enable_if_t<
+                !(sizeof...(VTypes) == 1 &&
+                  (is_same_v<decay_t<VTypes>, packed_tuple> && ...))>>
+  packed_tuple(VTypes&&... v)
+      : base(tuple_elements_tag(),
+             tuple<VTypes&&...>(std::forward<VTypes>(v)...)){};
+};
 
 /*====================Non-member functions====================*/
 
@@ -47,61 +183,223 @@ auto make_tuple(Types&&... elems) {
   return tuple<decay_t<Types>...>(std::forward<Types>(elems)...);
 }
 
-// get
-template <unsigned N>
-struct tuple_get {
-  template <typename Head, typename... Tail>
-  static auto apply(const tuple<Head, Tail...>& t) {
-    return tuple_get<N - 1>::apply(t.get_tail());
-  }
-};
+// get: element N by reference, so that access does not copy the element;
+// the element of an rvalue tuple is returned as an rvalue and can be moved
+// out
+template <size_t N, typename... Types>
+decltype(auto) get(tuple<Types...>& t) {
+  return tuple_leaf_get<N>(t);
+}
 
-template <>
-struct tuple_get<0> {
-  template <typename Head, typename... Tail>
-  static auto apply(const tuple<Head, Tail...>& t) {
-    return t.get_head();
-  }
-};
+template <size_t N, typename... Types>
+decltype(auto) get(const tuple<Types...>& t) {
+  return tuple_leaf_get<N>(t);
+}
+
+template <size_t N, typename... Types>
+decltype(auto) get(tuple<Types...>&& t) {
+  return tuple_leaf_get<N>(std::move(t));
+}
+
+// get by type: the element of type T, which must occur exactly once
+template <typename T, typename... Types>
+T& get(tuple<Types...>& t) {
+  return tuple_type_get<T>(t);
+}
+
+template <typename T, typename... Types>
+const T& get(const tuple<Types...>& t) {
+  return tuple_type_get<T>(t);
+}
+
+template <typename T, typename... Types>
+T&& get(tuple<Types...>&& t) {
+  return tuple_type_get<T>(std::move(t));
+}
+
+// get for packed_tuple: element N by its index in the declaration, not in
+// the layout
+template <size_t N, typename... Types>
+decltype(auto) get(packed_tuple<Types...>& t) {
+  return tuple_leaf_get<N>(t);
+}
+
+template <size_t N, typename... Types>
+decltype(auto) get(const packed_tuple<Types...>& t) {
+  return tuple_leaf_get<N>(t);
+}
+
+template <size_t N, typename... Types>
+decltype(auto) get(packed_tuple<Types...>&& t) {
+  return tuple_leaf_get<N>(std::move(t));
+}
+
+template <typename T, typename... Types>
+T& get(packed_tuple<Types...>& t) {
+  return tuple_type_get<T>(t);
+}
+
+template <typename T, typename... Types>
+const T& get(const packed_tuple<Types...>& t) {
+  return tuple_type_get<T>(t);
+}
 
-template <unsigned N, typename... Types>
-auto get(const tuple<Types...>& t) {
-  return tuple_get<N>::apply(t);
+template <typename T, typename... Types>
+T&& get(packed_tuple<Types...>&& t) {
+  return tuple_type_get<T>(std::move(t));
 }
 
 // operator==
-bool operator==(const tuple<>&, const tuple<>&) {
-  return true;
+template <typename... Types1, typename... Types2, size_t... I>
+bool tuple_equal(const tuple<Types1...>& lhs, const tuple<Types2...>& rhs,
+                 std::index_sequence<I...>) {
+  return ((tuple_leaf_get<I>(lhs) == tuple_leaf_get<I>(rhs)) && ...);
 }
 
-template <typename Head1, typename... Tail1, typename Head2, typename... Tail2,
-          typename = enable_if_t<sizeof...(Tail1) == sizeof...(Tail2)>>
-bool operator==(const tuple<Head1, Tail1...>& lhs, const tuple<Head2, Tail2...> rhs) {
-  return lhs.get_head() == rhs.get_head() && lhs.get_tail() == rhs.get_tail();
+template <typename... Types1, typename... Types2,
+          typename = enable_if_t<sizeof...(Types1) == sizeof...(Types2)>>
+bool operator==(const tuple<Types1...>& lhs, const tuple<Types2...>& rhs) {
+  return tuple_equal(lhs, rhs, std::make_index_sequence<sizeof...(Types1)>());
 }
 
 // operator<<
-void print_tuple(std::ostream& strm, const tuple<>, bool is_first) {
+template <typename... Types, size_t... I>
+void print_tuple(std::ostream& strm, const tuple<Types...>& t,
+                 std::index_sequence<I...>) {
+  strm << '(';
+  ((strm << (I == 0 ? "" : ", ") << tuple_leaf_get<I>(t)), ...);
   strm << ')';
 }
 
-template<typename Head, typename... Tail>
-void print_tuple(std::ostream& strm, const tuple<Head, Tail...> t, bool is_first=true) {
-  strm << (is_first ? "(" : ", ");
-  strm << t.get_head();
-  print_tuple(strm, t.get_tail(), false);
-}
-
-template<typename... Types>
+template <typename... Types>
 std::ostream& operator<<(std::ostream& strm, const tuple<Types...>& t) {
-  print_tuple(strm, t);
+  print_tuple(strm, t, std::make_index_sequence<sizeof...(Types)>());
   return strm;
 }
 
-template <>
-std::ostream& operator<<(std::ostream& strm, const tuple<>& t) {
-  strm << "()";
-  return strm;
+// tuple_size: the number of elements of a tuple or packed_tuple
+template <typename Tuple>
+struct tuple_size;
+
+template <typename... Types>
+struct tuple_size<tuple<Types...>>
+    : integral_constant<size_t, sizeof...(Types)> {};
+
+template <typename... Types>
+struct tuple_size<packed_tuple<Types...>>
+    : integral_constant<size_t, sizeof...(Types)> {};
+
+template <typename Tuple>
+inline constexpr size_t tuple_size_v = tuple_size<Tuple>::value;
+
+// tuple_element: the type of element I, deduced from the leaf like
+// tuple_leaf_get does
+template <size_t I, typename T>
+type_identity<T> tuple_leaf_type(const tuple_leaf<I, T>&);
+
+template <size_t I, typename Tuple>
+struct tuple_element
+    : decltype(tuple_leaf_type<I>(std::declval<const Tuple&>())) {};
+
+template <size_t I, typename Tuple>
+using tuple_element_t = typename tuple_element<I, Tuple>::type;
+
+// The functions below call `f` once per element. Each is a single fold
+// expression or pack expansion over an index sequence, so the calls are
+// emitted as straight-line code, with no recursion to inline through
+
+// apply: f(elements of t...)
+template <typename F, typename Tuple, size_t... I>
+decltype(auto) apply_impl(F&& f, Tuple&& t, std::index_sequence<I...>) {
+  return std::forward<F>(f)(get<I>(std::forward<Tuple>(t))...);
+}
+
+template <typename F, typename Tuple>
+decltype(auto) apply(F&& f, Tuple&& t) {
+  return apply_impl(
+      std::forward<F>(f), std::forward<Tuple>(t),
+      std::make_index_sequence<tuple_size_v<remove_cvref_t<Tuple>>>());
+}
+
+// f(element I of each of ts...)
+template <size_t I, typename F, typename... Tuples>
+decltype(auto) tuple_zip_call(F& f, Tuples&&... ts) {
+  return f(get<I>(std::forward<Tuples>(ts))...);
+}
+
+// tuple_for_each: f(element I of t, element I of each of rest...) for each I
+// in order; given several tuples of one size, iterates over them zipped
+template <typename F, size_t... I, typename... Tuples>
+void tuple_for_each_impl(F& f, std::index_sequence<I...>, Tuples&&... ts) {
+  (tuple_zip_call<I>(f, std::forward<Tuples>(ts)...), ...);
+}
+
+template <typename F, typename Tuple, typename... Tuples>
+void tuple_for_each(F&& f, Tuple&& t, Tuples&&... rest) {
+  constexpr size_t size = tuple_size_v<remove_cvref_t<Tuple>>;
+  static_assert(((tuple_size_v<remove_cvref_t<Tuples>> == size) && ...),
+                "zipped tuples must have equal sizes");
+  tuple_for_each_impl(f, std::make_index_sequence<size>(),
+                      std::forward<Tuple>(t), std::forward<Tuples>(rest)...);
+}
+
+// tuple_transform: the tuple of the results of tuple_for_each's calls
+template <typename F, size_t... I, typename... Tuples>
+auto tuple_transform_impl(F& f, std::index_sequence<I...>, Tuples&&... ts) {
+  // braced initialization evaluates the calls in order
+  return tuple<decay_t<decltype(tuple_zip_call<I>(
+      f, std::forward<Tuples>(ts)...))>...>{
+      tuple_zip_call<I>(f, std::forward<Tuples>(ts)...)...};
+}
+
+template <typename F, typename Tuple, typename... Tuples>
+auto tuple_transform(F&& f, Tuple&& t, Tuples&&... rest) {
+  constexpr size_t size = tuple_size_v<remove_cvref_t<Tuple>>;
+  static_assert(((tuple_size_v<remove_cvref_t<Tuples>> == size) && ...),
+                "zipped tuples must have equal sizes");
+  return tuple_transform_impl(f, std::make_index_sequence<size>(),
+                              std::forward<Tuple>(t),
+                              std::forward<Tuples>(rest)...);
+}
+
+// tuple_cat: element K of the result is element inner[K] of argument
+// outer[K]; both tables are computed at compile time, so that each element is
+// fetched with two leaf accesses
+template <size_t... Sizes>
+struct tuple_cat_index {
+  static constexpr size_t size = (Sizes + ... + 0);
+
+  constexpr tuple_cat_index() {
+    size_t sizes[] = {Sizes..., 0};
+    size_t k = 0;
+    for (size_t t = 0; t < sizeof...(Sizes); t++) {
+      for (size_t i = 0; i < sizes[t]; i++) {
+        outer[k] = t;
+        inner[k] = i;
+        k++;
+      }
+    }
+  }
+
+  size_t outer[size + 1] = {};
+  size_t inner[size + 1] = {};
+};
+
+template <typename Index, typename Tuples, typename Refs, size_t... K>
+auto tuple_cat_impl([[maybe_unused]] Refs&& refs, std::index_sequence<K...>) {
+  constexpr Index index;
+  using result = tuple<tuple_element_t<
+      index.inner[K], tuple_element_t<index.outer[K], Tuples>>...>;
+  return result(tuple_leaf_get<index.inner[K]>(
+      tuple_leaf_get<index.outer[K]>(std::move(refs)))...);
+}
+
+template <typename... Tuples>
+auto tuple_cat(Tuples&&... ts) {
+  using index = tuple_cat_index<tuple_size_v<remove_cvref_t<Tuples>>...>;
+  return tuple_cat_impl<index, tuple<remove_cvref_t<Tuples>...>>(
+      tuple<Tuples&&...>(std::forward<Tuples>(ts)...),
+      std::make_index_sequence<index::size>());
 }
 
 // tuple - is_empty
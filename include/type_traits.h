@@ -237,6 +237,13 @@ struct is_aggregate;
 template <typename T>
 inline constexpr bool is_aggregate_v = is_aggregate<T>::value;
 
+// has_unique_object_representations
+template <typename T>
+struct has_unique_object_representations;
+template <typename T>
+inline constexpr bool has_unique_object_representations_v =
+    has_unique_object_representations<T>::value;
+
 // is_signed
 template <typename T>
 struct is_signed;
@@ -839,6 +846,11 @@ struct is_final : bool_constant<__is_final(T)> {};
 template <typename T>
 struct is_aggregate : bool_constant<__is_aggregate(T)> {};
 
+// has_unique_object_representations
+template <typename T>
+struct has_unique_object_representations
+    : bool_constant<__has_unique_object_representations(T)> {};
+
 // is_signed
 template <typename T, bool = is_arithmetic_v<T>>
 struct is_signed_impl : bool_constant<T(-1) < T(0)> {};
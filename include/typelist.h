@@ -1,6 +1,8 @@
 #ifndef TYPELIST_H_
 #define TYPELIST_H_
 
+#include <utility>
+
 #include "type_traits.h"
 
 namespace stl {
@@ -55,31 +57,47 @@ struct push_front<typelist<Elements...>, NewElement> {
 template <typename List, typename NewElement>
 using push_front_t = typename push_front<List, NewElement>::type;
 
-// nth_element
-template <typename List, unsigned N>
-struct nth_element : nth_element<pop_front_t<List>, N - 1> {};
+// The algorithms below work on a whole list by pack expansion rather than by
+// recursion over pop_front, which takes N nested instantiations for N
+// elements and exceeds the compiler's depth limit beyond a few hundred
 
-template <typename List>
-struct nth_element<List, 0> : front<List> {};
+// indexed_types<index_sequence<I...>, Elements...> derives from one
+// indexed_type<I, E> per element, so that the element of index I is deduced
+// from the base in a single overload resolution
+template <size_t I, typename T>
+struct indexed_type {};
 
-template <typename List, unsigned N>
-using nth_element_t = typename nth_element<List, N>::type;
+template <typename Indices, typename... Elements>
+struct indexed_types;
 
-// largest_type
-template <typename List, bool IsEmpty = is_list_empty_v<List>>
-struct largest_type {
-  using first = front_t<List>;
-  using rest = typename largest_type<pop_front_t<List>>::type;
-  using type = stl::conditional_t<sizeof(first) >= sizeof(rest), first, rest>;
-};
+template <size_t... I, typename... Elements>
+struct indexed_types<std::index_sequence<I...>, Elements...>
+    : indexed_type<I, Elements>... {};
 
-template <typename List>
-struct largest_type<List, true> {
-  using type = char;
+template <size_t I, typename T>
+type_identity<T> select_indexed(const indexed_type<I, T>*);
+
+template <size_t I, typename Map>
+using select_indexed_t =
+    typename decltype(select_indexed<I>(static_cast<Map*>(nullptr)))::type;
+
+// the elements by their indices in the list
+template <typename... Elements>
+using index_map =
+    indexed_types<std::index_sequence_for<Elements...>, Elements...>;
+
+// nth_element
+template <typename List, unsigned N>
+struct nth_element;
+
+template <template <typename...> class List, typename... Elements, unsigned N>
+struct nth_element<List<Elements...>, N> {
+  static_assert(N < sizeof...(Elements), "index out of range");
+  using type = select_indexed_t<N, index_map<Elements...>>;
 };
 
-template <typename List>
-using largest_type_t = typename largest_type<List>::type;
+template <typename List, unsigned N>
+using nth_element_t = typename nth_element<List, N>::type;
 
 // push_back
 template <typename List, typename NewElement>
@@ -93,65 +111,305 @@ struct push_back<typelist<Elements...>, NewElement> {
 template <typename List, typename NewElement>
 using push_back_t = typename push_back<List, NewElement>::type;
 
+// reverse and pop_back move elements from the list to the result eight at a
+// time, which takes N / 8 instantiations instead of N. Reaching each element
+// through an index_map would take one instantiation, but a lookup among N
+// bases per element, which costs more for long lists
+
+// reverse_onto<List, Reversed...>: reverse of List, followed by Reversed...
+template <typename List, typename... Reversed>
+struct reverse_onto;
+
+template <template <typename...> class List, typename... Reversed>
+struct reverse_onto<List<>, Reversed...> {
+  using type = List<Reversed...>;
+};
+
+template <template <typename...> class List, typename E0, typename... Rest,
+          typename... Reversed>
+struct reverse_onto<List<E0, Rest...>, Reversed...>
+    : reverse_onto<List<Rest...>, E0, Reversed...> {};
+
+template <template <typename...> class List, typename E0, typename E1,
+          typename E2, typename E3, typename E4, typename E5, typename E6,
+          typename E7, typename... Rest, typename... Reversed>
+struct reverse_onto<List<E0, E1, E2, E3, E4, E5, E6, E7, Rest...>,
+                    Reversed...>
+    : reverse_onto<List<Rest...>, E7, E6, E5, E4, E3, E2, E1, E0,
+                   Reversed...> {};
+
 // reverse
-template <typename List, bool IsEmpty = is_list_empty_v<List>>
-struct reverse;
+template <typename List>
+struct reverse : reverse_onto<List> {};
 
 template <typename List>
 using reverse_t = typename reverse<List>::type;
 
-template <typename List>
-struct reverse<List, false>
-    : push_back<reverse_t<pop_front_t<List>>, front_t<List>> {};
+// pop_back_onto<List, Init...>: Init..., followed by List without its last
+// element
+template <typename List, typename... Init>
+struct pop_back_onto;
 
-template <typename List>
-struct reverse<List, true> {
-  using type = List;
+template <template <typename...> class List, typename Last, typename... Init>
+struct pop_back_onto<List<Last>, Init...> {
+  using type = List<Init...>;
 };
 
+template <template <typename...> class List, typename E0, typename E1,
+          typename... Rest, typename... Init>
+struct pop_back_onto<List<E0, E1, Rest...>, Init...>
+    : pop_back_onto<List<E1, Rest...>, Init..., E0> {};
+
+template <template <typename...> class List, typename E0, typename E1,
+          typename E2, typename E3, typename E4, typename E5, typename E6,
+          typename E7, typename E8, typename... Rest, typename... Init>
+struct pop_back_onto<List<E0, E1, E2, E3, E4, E5, E6, E7, E8, Rest...>,
+                     Init...>
+    : pop_back_onto<List<E8, Rest...>, Init..., E0, E1, E2, E3, E4, E5, E6,
+                    E7> {};
+
 // pop_back
 template <typename List>
-struct pop_back : reverse<pop_front_t<reverse_t<List>>> {};
+struct pop_back : pop_back_onto<List> {};
 
 template <typename List>
 using pop_back_t = typename pop_back<List>::type;
 
 // transform
-template <typename List, template <typename> class MetaFun,
-          bool IsEmpty = is_list_empty_v<List>>
+template <typename List, template <typename> class MetaFun>
 struct transform;
 
-template <typename List, template <typename> class MetaFun>
-using transform_t = typename transform<List, MetaFun>::type;
+template <template <typename...> class List, typename... Elements,
+          template <typename> class MetaFun>
+struct transform<List<Elements...>, MetaFun> {
+  using type = List<MetaFun<Elements>...>;
+};
 
 template <typename List, template <typename> class MetaFun>
-struct transform<List, MetaFun, false>
-    : push_front<transform_t<pop_front_t<List>, MetaFun>,
-                 MetaFun<front_t<List>>> {};
+using transform_t = typename transform<List, MetaFun>::type;
 
-template <typename List, template <typename> class MetaFun>
-struct transform<List, MetaFun, true> {
-  using type = List;
+// accumulate: F<...F<F<I, E0>, E1>..., En>, computed by a fold expression
+// over an operator on accumulate_state, which the compiler evaluates as one
+// expression instead of N nested instantiations
+template <template <typename, typename> class F, typename Result>
+struct accumulate_state {
+  using type = Result;
 };
 
-// accumulate
-template <typename List, template <typename, typename> class F, typename I,
-          bool IsEmpty = is_list_empty_v<List>>
-struct accumulate {};
+template <template <typename, typename> class F, typename Result,
+          typename Element>
+accumulate_state<F, F<Result, Element>> operator+(accumulate_state<F, Result>,
+                                                  type_identity<Element>);
 
 template <typename List, template <typename, typename> class F, typename I>
-struct accumulate<List, F, I, false>
-    : accumulate<pop_front_t<List>, F, F<I, front_t<List>>> {};
+struct accumulate;
 
-template <typename List, template <typename, typename> class F, typename I>
-struct accumulate<List, F, I, true> {
-  using type = I;
-};
+template <template <typename...> class List, typename... Elements,
+          template <typename, typename> class F, typename I>
+struct accumulate<List<Elements...>, F, I>
+    : decltype((accumulate_state<F, I>() + ... +
+                type_identity<Elements>())) {};
 
 template <typename List, template <typename, typename> class F, typename I>
 using accumulate_t = typename accumulate<List, F, I>::type;
 
+// largest_type: the first of the largest elements, or char for an empty list
+template <typename List>
+struct largest_type;
+
+template <typename List>
+using largest_type_t = typename largest_type<List>::type;
+
+template <typename T, typename U>
+using larger_type = conditional_t<(sizeof(U) > sizeof(T)), U, T>;
+
+template <template <typename...> class List>
+struct largest_type<List<>> {
+  using type = char;
+};
+
+template <template <typename...> class List, typename Head, typename... Tail>
+struct largest_type<List<Head, Tail...>>
+    : accumulate<List<Tail...>, larger_type, Head> {};
+
+// contains: whether T is an element of the list
+template <typename List, typename T>
+struct contains;
+
+template <template <typename...> class List, typename... Elements,
+          typename T>
+struct contains<List<Elements...>, T>
+    : bool_constant<(is_same_v<T, Elements> || ...)> {};
+
+template <typename List, typename T>
+inline constexpr bool contains_v = contains<List, T>::value;
+
+// index_of: the index of the first element T of the list
+template <typename List, typename T>
+struct index_of;
+
+template <template <typename...> class List, typename... Elements,
+          typename T>
+struct index_of<List<Elements...>, T> {
+  static_assert((is_same_v<T, Elements> || ...), "type not in the list");
+
+  static constexpr size_t find() {
+    constexpr bool matches[] = {is_same_v<T, Elements>...};
+    size_t i = 0;
+    while (!matches[i]) {
+      i++;
+    }
+    return i;
+  }
+
+  static constexpr size_t value = find();
+};
+
+template <typename List, typename T>
+inline constexpr size_t index_of_v = index_of<List, T>::value;
+
+// select_indices: the elements of the given indices, in the given order
+template <typename List, typename Indices>
+struct select_indices;
+
+template <template <typename...> class List, typename... Elements,
+          size_t... I>
+struct select_indices<List<Elements...>, std::index_sequence<I...>> {
+  using type = List<select_indexed_t<I, index_map<Elements...>>...>;
+};
+
+// kept_indices<N>: the indices i < N for which keep[i] holds, in order
+template <size_t N>
+struct kept_indices {
+  constexpr kept_indices(const bool (&keep)[N + 1]) {
+    for (size_t i = 0; i < N; i++) {
+      if (keep[i]) {
+        index[size++] = i;
+      }
+    }
+  }
+
+  size_t index[N + 1] = {};
+  size_t size = 0;
+};
+
+// select_kept: the elements of the indices in Kept, a kept_indices
+template <typename List, auto Kept,
+          typename = std::make_index_sequence<Kept.size>>
+struct select_kept;
+
+template <typename List, auto Kept, size_t... J>
+struct select_kept<List, Kept, std::index_sequence<J...>>
+    : select_indices<List, std::index_sequence<Kept.index[J]...>> {};
+
+// filter: the elements E for which Pred<E>::value holds, in order
+template <typename List, template <typename> class Pred>
+struct filter;
+
+template <template <typename...> class List, typename... Elements,
+          template <typename> class Pred>
+struct filter<List<Elements...>, Pred> {
+  static constexpr bool keep[] = {Pred<Elements>::value..., false};
+
+  using type = typename select_kept<
+      List<Elements...>, kept_indices<sizeof...(Elements)>(keep)>::type;
+};
+
+template <typename List, template <typename> class Pred>
+using filter_t = typename filter<List, Pred>::type;
+
+// unique: the first occurrence of each element, in order: the elements whose
+// index is that of the first element of their type. Every pair of elements is
+// compared, so the comparison is the builtin behind is_same, which
+// instantiates nothing, in a member of unique_impl rather than index_of, which
+// would instantiate a class over the whole list once per element
+template <typename List, typename Indices>
+struct unique_impl;
+
+template <template <typename...> class List, typename... Elements,
+          size_t... I>
+struct unique_impl<List<Elements...>, std::index_sequence<I...>> {
+  template <typename T>
+  static constexpr size_t first_index() {
+    constexpr bool matches[] = {__is_same(T, Elements)...};
+    size_t i = 0;
+    while (!matches[i]) {
+      i++;
+    }
+    return i;
+  }
+
+  static constexpr bool keep[] = {(first_index<Elements>() == I)..., false};
+
+  using type = typename select_kept<
+      List<Elements...>, kept_indices<sizeof...(Elements)>(keep)>::type;
+};
+
+template <typename List>
+struct unique;
+
+template <template <typename...> class List, typename... Elements>
+struct unique<List<Elements...>>
+    : unique_impl<List<Elements...>, std::index_sequence_for<Elements...>> {};
+
+template <typename List>
+using unique_t = typename unique<List>::type;
+
+// sort: a stable sort, which places T before U when Compare<T, U>::value
+// holds. Compare must be a strict weak order, such as greater_alignment
+template <typename List, template <typename, typename> class Compare>
+struct sort;
+
+template <template <typename...> class List, typename... Elements,
+          template <typename, typename> class Compare>
+struct sort<List<Elements...>, Compare> {
+  static constexpr size_t size = sizeof...(Elements);
+
+  // goes_before<A>::value[j]: whether element j goes before A
+  template <typename A>
+  struct goes_before {
+    static constexpr bool value[] = {Compare<Elements, A>::value..., false};
+  };
+
+  // source[k]: the index in the list of the element that goes to index k
+  struct order {
+    constexpr order() {
+      const bool* before[] = {goes_before<Elements>::value..., nullptr};
+      for (size_t i = 0; i < size; i++) {
+        // the elements that go before element i, and the equivalent
+        // elements that precede it in the list
+        size_t position = 0;
+        for (size_t j = 0; j < size; j++) {
+          if (before[i][j] || (j < i && !before[j][i])) {
+            position++;
+          }
+        }
+        source[position] = i;
+      }
+    }
+
+    size_t source[size + 1] = {};
+  };
+
+  static constexpr order sorted{};
+
+  template <size_t... K>
+  static auto select(std::index_sequence<K...>) ->
+      typename select_indices<List<Elements...>,
+                              std::index_sequence<sorted.source[K]...>>::type;
+
+  using type = decltype(select(std::make_index_sequence<size>()));
+};
+
+template <typename List, template <typename, typename> class Compare>
+using sort_t = typename sort<List, Compare>::type;
+
+// comparators for sort
+template <typename T, typename U>
+struct greater_alignment : bool_constant<(alignof(T) > alignof(U))> {};
 
+template <typename T, typename U>
+struct greater_size : bool_constant<(sizeof(T) > sizeof(U))> {};
 
 };  // namespace stl
 
@@ -24,6 +24,31 @@ constexpr remove_reference_t<T>&& move(T&& t) noexcept {
   return static_cast<remove_reference_t<T>&&>(t);
 }
 
+// in_place_t, in_place_type_t, in_place_index_t: tags that select the
+// constructor that constructs the value, the alternative T, or the
+// alternative of index I in place from the remaining arguments
+struct in_place_t {
+  explicit in_place_t() = default;
+};
+
+inline constexpr in_place_t in_place{};
+
+template <typename T>
+struct in_place_type_t {
+  explicit in_place_type_t() = default;
+};
+
+template <typename T>
+inline constexpr in_place_type_t<T> in_place_type{};
+
+template <size_t I>
+struct in_place_index_t {
+  explicit in_place_index_t() = default;
+};
+
+template <size_t I>
+inline constexpr in_place_index_t<I> in_place_index{};
+
 }; // namespace stl
 
 #endif // UTILITY_H_
\ No newline at end of file
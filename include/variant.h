@@ -0,0 +1,520 @@
+#ifndef VARIANT_H_
+#define VARIANT_H_
+
+#include <exception>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "type_traits.h"
+#include "typelist.h"
+#include "utility.h"
+
+/*============================================================
+============================Variant===========================
+==============================================================*/
+
+// variant<Types...> holds a value of one of Types... in storage sized by
+// largest_type_t, with the index of the alternative in the smallest unsigned
+// type that has room for it. Operations on the held value go through
+// variant_dispatch, which selects the alternative with a switch when there
+// are few of them, so that the compiler can inline every case, and with one
+// indirect call through a table of function pointers otherwise. Neither
+// tests the alternatives one by one
+
+namespace stl {
+
+class bad_variant_access : public std::exception {
+ public:
+  const char* what() const noexcept override { return "bad variant access"; }
+};
+
+inline constexpr size_t variant_npos = static_cast<size_t>(-1);
+
+// the smallest unsigned type for the indices of N alternatives and the
+// marker of a valueless variant, which is the largest value of the type: the
+// indices 0 to N - 1 are all below it
+template <size_t N>
+using variant_index_t =
+    conditional_t<(N <= 255), unsigned char,
+                  conditional_t<(N <= 65535), unsigned short, unsigned>>;
+
+template <typename... Types>
+class variant;
+
+// variant_size
+template <typename Variant>
+struct variant_size;
+
+template <typename... Types>
+struct variant_size<variant<Types...>>
+    : integral_constant<size_t, sizeof...(Types)> {};
+
+template <typename Variant>
+inline constexpr size_t variant_size_v = variant_size<Variant>::value;
+
+// variant_alternative
+template <size_t I, typename Variant>
+struct variant_alternative;
+
+template <size_t I, typename... Types>
+struct variant_alternative<I, variant<Types...>>
+    : nth_element<typelist<Types...>, I> {};
+
+template <size_t I, typename Variant>
+using variant_alternative_t = typename variant_alternative<I, Variant>::type;
+
+/*====================Dispatch====================*/
+
+// the most alternatives that variant_dispatch selects with a switch
+inline constexpr size_t variant_switch_max = 8;
+
+// f(integral_constant<size_t, I>()), or nothing for the switch cases past
+// the last alternative, which are never taken
+template <size_t I, size_t N, typename R, typename F>
+R variant_case(F& f) {
+  if constexpr (I < N) {
+    return f(integral_constant<size_t, I>());
+  } else {
+    __builtin_unreachable();
+  }
+}
+
+template <typename R, typename F, size_t... I>
+R variant_table(size_t index, F& f, std::index_sequence<I...>) {
+  static constexpr R (*table[])(F&) = {
+      &variant_case<I, sizeof...(I), R, F>...};
+  return table[index](f);
+}
+
+// variant_dispatch<N>(index, f): f(integral_constant<size_t, index>()), for
+// an index less than N. f must return the same type for every index
+template <size_t N, typename F>
+decltype(auto) variant_dispatch(size_t index, F&& f) {
+  using R = decltype(f(integral_constant<size_t, 0>()));
+  static_assert(
+      []<size_t... I>(std::index_sequence<I...>) {
+        return (is_same_v<R, decltype(f(integral_constant<size_t, I>()))> &&
+                ...);
+      }(std::make_index_sequence<N>()),
+      "the result must have the same type for every alternative");
+
+  if constexpr (N <= variant_switch_max) {
+    switch (index) {
+      case 0:
+        return variant_case<0, N, R>(f);
+      case 1:
+        return variant_case<1, N, R>(f);
+      case 2:
+        return variant_case<2, N, R>(f);
+      case 3:
+        return variant_case<3, N, R>(f);
+      case 4:
+        return variant_case<4, N, R>(f);
+      case 5:
+        return variant_case<5, N, R>(f);
+      case 6:
+        return variant_case<6, N, R>(f);
+      default:
+        return variant_case<7, N, R>(f);
+    }
+  } else {
+    return variant_table<R>(index, f, std::make_index_sequence<N>());
+  }
+}
+
+/*====================Converting construction====================*/
+
+// The converting constructor and assignment take the alternative that
+// overload resolution selects among one function select(T) per alternative
+// T, as if by initializing a T from the argument. Alternatives that the
+// argument would be narrowed to take no part, so that a pointer does not
+// select bool
+
+template <typename T>
+using variant_array = T[1];
+
+template <typename U, size_t I, typename T, typename = void>
+struct variant_overload {
+  static void select();
+};
+
+template <typename U, size_t I, typename T>
+struct variant_overload<
+    U, I, T, void_t<decltype(variant_array<T>{std::declval<U>()})>> {
+  static integral_constant<size_t, I> select(T);
+};
+
+template <typename U, typename Indices, typename... Types>
+struct variant_overloads;
+
+template <typename U, size_t... I, typename... Types>
+struct variant_overloads<U, std::index_sequence<I...>, Types...>
+    : variant_overload<U, I, Types>... {
+  using variant_overload<U, I, Types>::select...;
+};
+
+// integral_constant of the index of the alternative that a U initializes.
+// An alias, so that a U that initializes none fails substitution where it is
+// used instead of being a hard error
+template <typename U, typename... Types>
+using variant_select_t =
+    decltype(variant_overloads<U, std::index_sequence_for<Types...>,
+                               Types...>::select(std::declval<U>()));
+
+/*====================Variant====================*/
+
+template <typename... Types>
+class variant {
+  static_assert(sizeof...(Types) != 0, "a variant needs an alternative");
+
+  using index_type = variant_index_t<sizeof...(Types)>;
+  static constexpr index_type valueless = static_cast<index_type>(-1);
+  static constexpr size_t count = sizeof...(Types);
+
+  template <size_t I>
+  using alternative = nth_element_t<typelist<Types...>, I>;
+
+  static constexpr bool trivially_destructible =
+      (is_trivially_destructible_v<Types> && ...);
+  static constexpr bool trivially_copy_constructible =
+      (is_trivially_copy_constructible_v<Types> && ...);
+  static constexpr bool trivially_move_constructible =
+      (is_trivially_move_constructible_v<Types> && ...);
+  static constexpr bool trivially_copy_assignable =
+      trivially_copy_constructible && trivially_destructible &&
+      (is_trivially_copy_assignable_v<Types> && ...);
+  static constexpr bool trivially_move_assignable =
+      trivially_move_constructible && trivially_destructible &&
+      (is_trivially_move_assignable_v<Types> && ...);
+
+  static constexpr bool copy_constructible =
+      (is_copy_constructible_v<Types> && ...);
+  static constexpr bool move_constructible =
+      (is_move_constructible_v<Types> && ...);
+  static constexpr bool copy_assignable =
+      copy_constructible && (is_copy_assignable_v<Types> && ...);
+  static constexpr bool move_assignable =
+      move_constructible && (is_move_assignable_v<Types> && ...);
+  static constexpr bool nothrow_move_constructible =
+      (is_nothrow_move_constructible_v<Types> && ...);
+  static constexpr bool nothrow_move_assignable =
+      nothrow_move_constructible &&
+      (is_nothrow_move_assignable_v<Types> && ...);
+
+ public:
+  /*====================Member functions====================*/
+
+  /**
+   * Default constructor
+   * Value-initializes the first alternative
+   */
+  variant() { construct<0>(); }
+
+  /**
+   * Copy constructor: a bitwise copy when every alternative can be copied
+   * that way. Deleted unless every alternative is copy constructible
+   */
+  variant(const variant&) requires trivially_copy_constructible = default;
+
+  variant(const variant& other) requires(copy_constructible &&
+                                         !trivially_copy_constructible) {
+    if (!other.valueless_by_exception()) {
+      dispatch(other.index_,
+               [&](auto i) { construct<i>(other.unchecked_get<i>()); });
+    }
+  }
+
+  /**
+   * Move constructor: a bitwise copy when every alternative can be moved
+   * that way. Does not throw unless moving an alternative does, so that
+   * containers of variants move them when they reallocate
+   */
+  variant(variant&&) requires trivially_move_constructible = default;
+
+  variant(variant&& other) noexcept(nothrow_move_constructible) requires(
+      move_constructible && !trivially_move_constructible) {
+    if (!other.valueless_by_exception()) {
+      dispatch(other.index_, [&](auto i) {
+        construct<i>(stl::move(other.unchecked_get<i>()));
+      });
+    }
+  }
+
+  /**
+   * Converting constructor: holds the alternative that `value` initializes
+   * @param value the value to hold
+   */
+  template <typename U,
+            typename = enable_if_t<!is_same_v<remove_cvref_t<U>, variant>>,
+            size_t I = variant_select_t<U, Types...>::value>
+  variant(U&& value) {
+    construct<I>(stl::forward<U>(value));
+  }
+
+  /**
+   * Constructs the alternative of index I, or the alternative T, in place
+   * @param args arguments of the alternative's constructor
+   */
+  template <size_t I, typename... Args>
+  explicit variant(in_place_index_t<I>, Args&&... args) {
+    construct<I>(stl::forward<Args>(args)...);
+  }
+
+  template <typename T, typename... Args>
+  explicit variant(in_place_type_t<T>, Args&&... args) {
+    construct<index_of_v<typelist<Types...>, T>>(stl::forward<Args>(args)...);
+  }
+
+  ~variant() requires trivially_destructible = default;
+  ~variant() { destroy(); }
+
+  variant& operator=(const variant&) requires trivially_copy_assignable =
+      default;
+
+  variant& operator=(const variant& other) requires(
+      copy_assignable && !trivially_copy_assignable) {
+    if (other.valueless_by_exception()) {
+      destroy();
+    } else if (index_ == other.index_) {
+      dispatch(index_,
+               [&](auto i) { unchecked_get<i>() = other.unchecked_get<i>(); });
+    } else {
+      dispatch(other.index_,
+               [&](auto i) { emplace<i>(other.unchecked_get<i>()); });
+    }
+    return *this;
+  }
+
+  variant& operator=(variant&&) requires trivially_move_assignable = default;
+
+  variant& operator=(variant&& other) noexcept(nothrow_move_assignable)
+    requires(move_assignable && !trivially_move_assignable)
+  {
+    if (other.valueless_by_exception()) {
+      destroy();
+    } else if (index_ == other.index_) {
+      dispatch(index_, [&](auto i) {
+        unchecked_get<i>() = stl::move(other.unchecked_get<i>());
+      });
+    } else {
+      dispatch(other.index_, [&](auto i) {
+        emplace<i>(stl::move(other.unchecked_get<i>()));
+      });
+    }
+    return *this;
+  }
+
+  /**
+   * Converting assignment: assigns to the held alternative if it is the one
+   * `value` selects, and otherwise holds that alternative instead
+   * @param value the value to hold
+   * @return *this
+   */
+  template <typename U,
+            typename = enable_if_t<!is_same_v<remove_cvref_t<U>, variant>>,
+            size_t I = variant_select_t<U, Types...>::value>
+  variant& operator=(U&& value) {
+    if (index_ == I) {
+      unchecked_get<I>() = stl::forward<U>(value);
+    } else {
+      emplace<I>(stl::forward<U>(value));
+    }
+    return *this;
+  }
+
+  /*==========Observers==========*/
+
+  /**
+   * Returns the index of the alternative held, or variant_npos if the
+   * variant is valueless
+   */
+  constexpr size_t index() const noexcept {
+    return valueless_by_exception() ? variant_npos : index_;
+  }
+
+  /**
+   * Checks whether the variant holds no value, which happens only when
+   * constructing a new alternative in place of the old one throws
+   */
+  constexpr bool valueless_by_exception() const noexcept {
+    return index_ == valueless;
+  }
+
+  /*==========Modifiers==========*/
+
+  /**
+   * Destroys the held value and constructs the alternative of index I, or
+   * the alternative T, in its place. If the construction throws, the
+   * variant is left valueless
+   * @param args arguments of the alternative's constructor
+   * @return reference to the new value
+   */
+  template <size_t I, typename... Args>
+  alternative<I>& emplace(Args&&... args) {
+    destroy();
+    construct<I>(stl::forward<Args>(args)...);
+    return unchecked_get<I>();
+  }
+
+  template <typename T, typename... Args>
+  T& emplace(Args&&... args) {
+    return emplace<index_of_v<typelist<Types...>, T>>(
+        stl::forward<Args>(args)...);
+  }
+
+  /**
+   * Returns the value held as alternative I, without checking that I is the
+   * alternative held
+   * @return reference to the value, an rvalue for an rvalue variant
+   */
+  template <size_t I>
+  alternative<I>& unchecked_get() & {
+    return *std::launder(reinterpret_cast<alternative<I>*>(storage_));
+  }
+
+  template <size_t I>
+  const alternative<I>& unchecked_get() const& {
+    return *std::launder(reinterpret_cast<const alternative<I>*>(storage_));
+  }
+
+  template <size_t I>
+  alternative<I>&& unchecked_get() && {
+    return stl::move(unchecked_get<I>());
+  }
+
+  template <size_t I>
+  const alternative<I>&& unchecked_get() const&& {
+    return stl::move(unchecked_get<I>());
+  }
+
+ private:
+  template <typename F>
+  static void dispatch(size_t index, F&& f) {
+    variant_dispatch<count>(index, f);
+  }
+
+  template <size_t I, typename... Args>
+  void construct(Args&&... args) {
+    index_ = valueless;
+    ::new (static_cast<void*>(storage_))
+        alternative<I>(stl::forward<Args>(args)...);
+    index_ = static_cast<index_type>(I);
+  }
+
+  void destroy() {
+    if constexpr (!trivially_destructible) {
+      if (!valueless_by_exception()) {
+        dispatch(index_,
+                 [this](auto i) { std::destroy_at(&unchecked_get<i>()); });
+      }
+    }
+    index_ = valueless;
+  }
+
+  alignas(Types...) unsigned char storage_[sizeof(
+      largest_type_t<typelist<Types...>>)];
+  index_type index_ = valueless;
+};
+
+/*====================Non-member functions====================*/
+
+// holds_alternative: whether v holds the alternative T
+template <typename T, typename... Types>
+constexpr bool holds_alternative(const variant<Types...>& v) noexcept {
+  return v.index() == index_of_v<typelist<Types...>, T>;
+}
+
+// get: the value of alternative I, or of alternative T; throws
+// bad_variant_access unless v holds it
+template <size_t I, typename... Types>
+auto& get(variant<Types...>& v) {
+  if (v.index() != I) {
+    throw bad_variant_access();
+  }
+  return v.template unchecked_get<I>();
+}
+
+template <size_t I, typename... Types>
+const auto& get(const variant<Types...>& v) {
+  if (v.index() != I) {
+    throw bad_variant_access();
+  }
+  return v.template unchecked_get<I>();
+}
+
+template <size_t I, typename... Types>
+auto&& get(variant<Types...>&& v) {
+  return stl::move(get<I>(v));
+}
+
+template <typename T, typename... Types>
+T& get(variant<Types...>& v) {
+  return get<index_of_v<typelist<Types...>, T>>(v);
+}
+
+template <typename T, typename... Types>
+const T& get(const variant<Types...>& v) {
+  return get<index_of_v<typelist<Types...>, T>>(v);
+}
+
+template <typename T, typename... Types>
+T&& get(variant<Types...>&& v) {
+  return stl::move(get<index_of_v<typelist<Types...>, T>>(v));
+}
+
+// get_if: a pointer to the value of alternative I, or of alternative T, or
+// nullptr unless v holds it
+template <size_t I, typename... Types>
+auto* get_if(variant<Types...>* v) noexcept {
+  return v && v->index() == I ? &v->template unchecked_get<I>() : nullptr;
+}
+
+template <size_t I, typename... Types>
+const auto* get_if(const variant<Types...>* v) noexcept {
+  return v && v->index() == I ? &v->template unchecked_get<I>() : nullptr;
+}
+
+template <typename T, typename... Types>
+T* get_if(variant<Types...>* v) noexcept {
+  return get_if<index_of_v<typelist<Types...>, T>>(v);
+}
+
+template <typename T, typename... Types>
+const T* get_if(const variant<Types...>* v) noexcept {
+  return get_if<index_of_v<typelist<Types...>, T>>(v);
+}
+
+// visit: f(the value held by v), dispatched by variant_dispatch. Throws
+// bad_variant_access if v is valueless
+template <typename F, typename Variant>
+decltype(auto) visit(F&& f, Variant&& v) {
+  if (v.valueless_by_exception()) {
+    throw bad_variant_access();
+  }
+  return variant_dispatch<variant_size_v<remove_cvref_t<Variant>>>(
+      v.index(), [&](auto i) -> decltype(auto) {
+        return stl::forward<F>(f)(
+            stl::forward<Variant>(v).template unchecked_get<i>());
+      });
+}
+
+// operator==: equal when both hold the same alternative with equal values,
+// or both are valueless
+template <typename... Types>
+bool operator==(const variant<Types...>& lhs, const variant<Types...>& rhs) {
+  if (lhs.index() != rhs.index()) {
+    return false;
+  }
+  if (lhs.valueless_by_exception()) {
+    return true;
+  }
+  return variant_dispatch<sizeof...(Types)>(lhs.index(), [&](auto i) {
+    return bool(lhs.template unchecked_get<i>() ==
+                rhs.template unchecked_get<i>());
+  });
+}
+
+};  // namespace stl
+
+#endif  // VARIANT_H_
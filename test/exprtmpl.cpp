@@ -1,6 +1,10 @@
 #include "exprtmpl.h"
 
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#include <string>
+#include <thread>
 
 using namespace stl;
 
@@ -53,9 +57,614 @@ void TestMultiplication() {
   std::cout << t[0] << '\n';
 }
 
+void TestScalarLifetime() {
+  std::cout << "==========Test Scalar Lifetime==========\n";
+  Array<int> x(4);
+  for (size_t i = 0; i < x.size(); i++) {
+    x[i] = i + 1;
+  }
+
+  // scalars and intermediate nodes are temporaries of the full-expression
+  // that builds `y`; they must still be valid when `y` is evaluated
+  auto y = (x + 1) * 3 + x * 2;
+  std::cout << "y = (x + 1) * 3 + x * 2 = ";
+  y.print();
+  for (size_t i = 0; i < x.size(); i++) {
+    assert(y[i] == (x[i] + 1) * 3 + x[i] * 2);
+  }
+
+  Array<int> z(4);
+  z = y;
+  assert(z[3] == 23);
+}
+
+void TestViews() {
+  std::cout << "==========Test Views==========\n";
+  Array<int> x(8);
+  for (size_t i = 0; i < x.size(); i++) {
+    x[i] = i;
+  }
+
+  auto s = slice(x, 2, 4);
+  std::cout << "slice(x, 2, 4) = ";
+  s.print();
+  assert(s.size() == 4 && s[0] == 2 && s[3] == 5);
+
+  auto even = stride(x, 0, 4, 2);
+  auto odd = stride(x, 1, 4, 2);
+  std::cout << "stride(x, 0, 4, 2) = ";
+  even.print();
+  auto sum = even + odd * 10;
+  std::cout << "even + odd * 10 = ";
+  sum.print();
+  assert(sum[0] == 10 && sum[3] == 6 + 70);
+
+  Array<size_t> idx(3);
+  idx[0] = 7;
+  idx[1] = 0;
+  idx[2] = 3;
+  auto g = gather(x, idx);
+  std::cout << "gather(x, {7, 0, 3}) = ";
+  g.print();
+  assert(g[0] == 7 && g[1] == 0 && g[2] == 3);
+
+  // views write through to the viewed storage
+  even = odd + 100;
+  std::cout << "x after even = odd + 100: ";
+  x.print();
+  assert(x[0] == 101 && x[6] == 107 && x[7] == 7);
+  auto mid = slice(s, 1, 2);
+  mid = mid * 0;
+  assert(x[3] == 0 && x[4] == 0 && x[5] == 5);
+}
+
+void TestTensor() {
+  std::cout << "==========Test Tensor==========\n";
+  Tensor<int, 2> m(2, 3);
+  for (size_t i = 0; i < 2; i++) {
+    for (size_t j = 0; j < 3; j++) {
+      m(i, j) = i * 3 + j;
+    }
+  }
+  std::cout << "m =\n";
+  m.print();
+
+  // a row vector is broadcast over the rows, a column over the columns
+  Tensor<int, 1> row(3);
+  row(0) = 1;
+  row(1) = 2;
+  row(2) = 3;
+  Tensor<int, 2> col(2, 1);
+  col(0, 0) = 100;
+  col(1, 0) = 200;
+
+  Tensor<int, 2> r(2, 3);
+  r = m + row * 10 + col;
+  std::cout << "m + row * 10 + col =\n";
+  r.print();
+  for (size_t i = 0; i < 2; i++) {
+    for (size_t j = 0; j < 3; j++) {
+      assert(r(i, j) == m(i, j) + row(j) * 10 + col(i, 0));
+    }
+  }
+
+  // rank and extent broadcasting combine in three dimensions
+  Tensor<int, 3> t(2, 2, 3);
+  t = 1 + m * col;
+  auto shape = (m * col + t).shape();
+  assert((shape == A_Shape<3>{{2, 2, 3}}));
+  assert(t(1, 1, 2) == 1 + 5 * 200);
+  assert((t * 2)(0, 1, 0) == 2 * (1 + 3 * 200));
+}
+
+void TestMatMul() {
+  std::cout << "==========Test MatMul==========\n";
+  // sizes that are not multiples of the register tile or the cache blocks
+  const size_t m = 101, k = 300, n = 37;
+  Tensor<double, 2> a(m, k), b(k, n), c(m, n);
+  Tensor<double, 1> x(k);
+  for (size_t i = 0; i < m; i++) {
+    for (size_t p = 0; p < k; p++) {
+      a(i, p) = (i * 7 + p * 3) % 11 - 5.0;
+    }
+  }
+  for (size_t p = 0; p < k; p++) {
+    x(p) = p % 5 - 2.0;
+    for (size_t j = 0; j < n; j++) {
+      b(p, j) = (p + j * 5) % 7 - 3.0;
+    }
+  }
+  for (size_t i = 0; i < m; i++) {
+    for (size_t j = 0; j < n; j++) {
+      c(i, j) = i + j;
+    }
+  }
+
+  auto naive = [&](size_t i, size_t j) {
+    double sum = 0;
+    for (size_t p = 0; p < k; p++) {
+      sum += a(i, p) * b(p, j);
+    }
+    return sum;
+  };
+
+  Tensor<double, 2> r(m, n);
+  r = matmul(a, b);
+  Tensor<double, 2> r4(m, n);
+  r4 = matmul(a, b, 4);
+  // the product composes with elementwise nodes and broadcasting
+  Tensor<double, 2> e(m, n);
+  e = matmul(a, b) + c * 2.0;
+  for (size_t i = 0; i < m; i++) {
+    for (size_t j = 0; j < n; j++) {
+      assert(r(i, j) == naive(i, j));
+      assert(r4(i, j) == naive(i, j));
+      assert(e(i, j) == naive(i, j) + 2.0 * c(i, j));
+    }
+  }
+
+  Tensor<double, 1> y(m);
+  y = matmul(a, x * 2.0, 3);
+  for (size_t i = 0; i < m; i++) {
+    double sum = 0;
+    for (size_t p = 0; p < k; p++) {
+      sum += a(i, p) * x(p) * 2.0;
+    }
+    assert(y(i) == sum);
+  }
+
+  // a destination that is also an operand is not overwritten too early
+  Tensor<int, 2> s(2, 2);
+  s(0, 0) = 1;
+  s(0, 1) = 2;
+  s(1, 0) = 3;
+  s(1, 1) = 4;
+  s = matmul(s, s);
+  std::cout << "s * s =\n";
+  s.print();
+  assert(s(0, 0) == 7 && s(0, 1) == 10 && s(1, 0) == 15 && s(1, 1) == 22);
+
+  // a stored expression evaluated again sees the new operands; 13 rows on 3
+  // threads are split into 3 bands of whole tiles
+  Tensor<int, 2> p(13, 2), q(2, 2), twice(13, 2);
+  for (size_t i = 0; i < 13; i++) {
+    p(i, 0) = i;
+    p(i, 1) = 1;
+  }
+  q(0, 0) = 1;
+  q(0, 1) = 0;
+  q(1, 0) = 0;
+  q(1, 1) = 1;
+  auto shifted = matmul(p, q, 3) + 1;
+  twice = shifted;
+  assert(twice(12, 0) == 13 && twice(12, 1) == 2);
+  q(0, 0) = 2;
+  twice = shifted;
+  assert(twice(12, 0) == 25 && twice(0, 0) == 1);
+
+  // evaluations on two threads each compute the product of their own
+  Tensor<int, 2> t1(13, 2), t2(13, 2);
+  std::thread w1([&] { t1 = shifted; });
+  std::thread w2([&] { t2 = shifted; });
+  w1.join();
+  w2.join();
+  for (size_t i = 0; i < 13; i++) {
+    assert(t1(i, 0) == int(2 * i + 1) && t2(i, 0) == int(2 * i + 1));
+  }
+}
+
+void TestOptimize() {
+  std::cout << "==========Test Optimize==========\n";
+  Array<int> x(4), y(4), z(4);
+  for (size_t i = 0; i < x.size(); i++) {
+    x[i] = i;
+    y[i] = 10 * i;
+  }
+
+  // scalars move to the right and fold together
+  auto folded = optimize(((1 + x) + 2).rep());
+  static_assert(is_same_v<decltype(folded),
+                          A_Add<int, SArray<int>, A_Scalar<int>>>);
+  assert(folded.rhs().value() == 3);
+  auto scaled = optimize((2 * (x * 3)).rep());
+  static_assert(is_same_v<decltype(scaled),
+                          A_Mult<int, SArray<int>, A_Scalar<int>>>);
+  assert(scaled.rhs().value() == 6);
+
+  // a * s + b becomes a fused multiply-add
+  auto fused = optimize((y + x * 5).rep());
+  static_assert(
+      is_same_v<decltype(fused),
+                A_FMA<int, SArray<int>, A_Scalar<int>, SArray<int>>>);
+
+  // leaves are not copied
+  static_assert(is_same_v<decltype(optimize(x.rep())), const SArray<int>&>);
+
+  z = 3 + (y + x * 5) * 2 + 4;
+  std::cout << "z = 3 + (y + x * 5) * 2 + 4 = ";
+  z.print();
+  for (size_t i = 0; i < z.size(); i++) {
+    assert(z[i] == 3 + (y[i] + x[i] * 5) * 2 + 4);
+  }
+
+  Array<double> a(3), b(3);
+  for (size_t i = 0; i < a.size(); i++) {
+    a[i] = 0.5 * i;
+  }
+  b = a * 4.0 + 1.0;
+  assert(b[0] == 1.0 && b[1] == 3.0 && b[2] == 5.0);
+}
+
+// whether `a + b` is an expression for an A and a B
+template <typename A, typename B, typename = void>
+struct has_plus : false_type {};
+
+template <typename A, typename B>
+struct has_plus<A, B, void_t<decltype(std::declval<A>() + std::declval<B>())>>
+    : true_type {};
+
+void TestMixedPrecision() {
+  std::cout << "==========Test Mixed Precision==========\n";
+  Array<int> i(3);
+  Array<float> f(3);
+  Array<double> d(3);
+  for (size_t k = 0; k < 3; k++) {
+    i[k] = k;
+    f[k] = 0.5f * k;
+    d[k] = 0.25 * k;
+  }
+
+  // operands are promoted to their common type
+  auto fd = f + d;
+  static_assert(is_same_v<decltype(fd[0]), double>);
+  auto id = i * 1.5;
+  static_assert(is_same_v<decltype(id[0]), double>);
+  auto fi = 2 + i * f;
+  static_assert(is_same_v<decltype(fi[0]), float>);
+  std::cout << "f + d = ";
+  fd.print();
+  assert(fd[2] == 1.5 && id[2] == 3.0 && fi[2] == 4.0f);
+
+  // 16-bit floating point storage converts to float for computation
+  static_assert(sizeof(bfloat16) == 2 && sizeof(float16) == 2);
+  assert(float16(1.0f).bits == 0x3C00);
+  assert(float16(65504.0f).bits == 0x7BFF);
+  assert(float16(65520.0f).bits == 0x7C00);
+  assert(float16(-2.0f).bits == 0xC000);
+  assert(float16(0x1p-24f).bits == 0x0001);
+  assert(static_cast<float>(float16(0x1p-20f)) == 0x1p-20f);
+  assert(static_cast<float>(float16(1.0f / 3)) == 0x1.554p-2f);
+  assert(bfloat16(1.0f).bits == 0x3F80);
+  assert(static_cast<float>(bfloat16(3.0f)) == 3.0f);
+  // ties round to even
+  assert(bfloat16(std::bit_cast<float>(0x3F808000u)).bits == 0x3F80);
+  assert(bfloat16(std::bit_cast<float>(0x3F818000u)).bits == 0x3F82);
+
+  Array<bfloat16> b(3);
+  Array<float16> h(3);
+  b = f * 4.0f;
+  h = f + 1.0f;
+  auto bh = b + h;
+  static_assert(is_same_v<decltype(bh[0]), float>);
+  std::cout << "b + h = ";
+  bh.print();
+  assert(bh[1] == 3.5f && bh[2] == 6.0f);
+
+  Tensor<float, 1> t(3);
+  t = Tensor<int, 1>(3) + 0.5f;
+  assert(t(0) == 0.5f);
+
+  // arithmetic types and 16-bit floats are scalars; other operands leave the
+  // operators out of overload resolution
+  static_assert(has_plus<const Array<float>&, bfloat16>::value);
+  static_assert(has_plus<float16, const Tensor<float, 1>&>::value);
+  static_assert(!has_plus<const Array<float>&, std::string>::value);
+  static_assert(!has_plus<const Tensor<float, 1>&, std::string>::value);
+  static_assert(!has_plus<std::string, const Array<int>&>::value);
+}
+
+void TestMMapArray() {
+  std::cout << "==========Test MMapArray==========\n";
+  char path[] = "/tmp/exprtmpl_mmap_XXXXXX";
+  int fd = mkstemp(path);
+  assert(fd >= 0);
+  double values[] = {1.5, 2.5, 3.5, 4.5};
+  assert(write(fd, values, sizeof(values)) == sizeof(values));
+  close(fd);
+
+  using CopyOnWrite = MMapArray<double, MMapMode::CopyOnWrite>;
+  Array<double, MMapArray<double>> ro{MMapArray<double>(path)};
+  Array<double, CopyOnWrite> cow{CopyOnWrite(path)};
+  assert(ro.size() == 4 && !ro.rep().writable() && cow.rep().writable());
+  // a read-only mapping cannot be written
+  static_assert(!is_assignable_v<decltype(ro[0]), double>);
+  static_assert(is_assignable_v<decltype(cow[0]), double>);
+  std::cout << "file = ";
+  ro.print();
+
+  Array<double> r(4);
+  r = ro * 2.0 + cow;
+  assert(r[0] == 4.5 && r[3] == 13.5);
+
+  // writes to a copy-on-write mapping do not reach the file
+  cow = ro * 10.0;
+  assert(cow[1] == 25.0 && ro[1] == 2.5);
+  Array<double, MMapArray<double>> reread{MMapArray<double>(path)};
+  assert(reread[1] == 2.5);
+
+  bool thrown = false;
+  try {
+    MMapArray<double> missing("/nonexistent/exprtmpl");
+  } catch (const std::system_error&) {
+    thrown = true;
+  }
+  assert(thrown);
+  std::remove(path);
+}
+
+void TestEvaluateChunked() {
+  std::cout << "==========Test Evaluate Chunked==========\n";
+  Array<long> x(10);
+  for (size_t i = 0; i < x.size(); i++) {
+    x[i] = i;
+  }
+
+  // chunks arrive in order; the last one is partial
+  Array<long> out(10);
+  size_t filled = 0, calls = 0;
+  evaluate_chunked(
+      x * 3L + 1L,
+      [&](const long* data, size_t count) {
+        assert(count == (calls < 3 ? 3 : 1));
+        for (size_t i = 0; i < count; i++) {
+          out[filled++] = data[i];
+        }
+        calls++;
+      },
+      3);
+  assert(calls == 4 && filled == 10);
+  for (size_t i = 0; i < x.size(); i++) {
+    assert(out[i] == 3 * x[i] + 1);
+  }
+
+  // the default chunk size covers small arrays in a single call
+  long checksum = 0;
+  evaluate_chunked(x + x, [&](const long* data, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+      checksum += data[i];
+    }
+  });
+  std::cout << "checksum of x + x = " << checksum << '\n';
+  assert(checksum == 90);
+}
+
+void TestSum() {
+  std::cout << "==========Test Sum==========\n";
+  Array<int> x(21), y(21);
+  for (size_t i = 0; i < x.size(); i++) {
+    x[i] = i;
+    y[i] = 2;
+  }
+  std::cout << "sum(x * y) = " << sum(x * y) << '\n';
+  assert(sum(x * y) == 420);
+  assert(sum(x + 1) == 231);
+
+  // 16-bit floats are summed in float: 3000 is past the integers float16
+  // holds exactly
+  Array<float16> h(3000);
+  Array<bfloat16> b(21);
+  for (size_t i = 0; i < h.size(); i++) {
+    h[i] = 1.0f;
+  }
+  for (size_t i = 0; i < b.size(); i++) {
+    b[i] = 0.5f;
+  }
+  static_assert(is_same_v<decltype(sum(h)), float>);
+  assert(sum(h) == 3000.0f && sum(b) == 10.5f);
+}
+
+void TestWhere() {
+  std::cout << "==========Test Where==========\n";
+  Array<double> x(8), y(8);
+  for (size_t i = 0; i < x.size(); i++) {
+    x[i] = static_cast<double>(i) - 3;
+  }
+  Array<bool> mask(8);
+  mask = x > 0.0;
+  mask.print();
+  assert(!mask[3] && mask[4]);
+
+  // clamp to [-1, 2] and scale, in one pass
+  y = where(x < -1, -1, where(x > 2, 2, x)) * 10;
+  y.print();
+  assert(y[0] == -10 && y[2] == -10 && y[3] == 0 && y[5] == 20 && y[7] == 20);
+
+  // masks compare in the promoted type and select between Arrays
+  Array<int> k(8);
+  for (size_t i = 0; i < k.size(); i++) {
+    k[i] = i % 2;
+  }
+  y = where(k == 1, x, x * x) + 1;
+  assert(y[0] == 10 && y[1] == -1 && y[4] == 2 && y[7] == 5);
+  assert(sum(where(x >= 0.5, 1, 0)) == 4);
+  assert(sum(where(k != 0, 1, 0)) == 4);
+  assert(sum(where(2 <= x, 1, 0)) == 3);
+}
+
+void TestScan() {
+  std::cout << "==========Test Scan==========\n";
+  Array<int> x(10);
+  for (size_t i = 0; i < x.size(); i++) {
+    x[i] = i + 1;
+  }
+  inclusive_scan(x).print();
+  exclusive_scan(x).print();
+  moving_sum(x, 3).print();
+  moving_average(x * 2, 4).print();
+  Array<int> y(10);
+  y = inclusive_scan(x) + exclusive_scan(x) * -1;
+  for (size_t i = 0; i < y.size(); i++) {
+    assert(y[i] == x[i]);
+  }
+
+  // large arrays are scanned in parallel ranges; compare with serial sums
+  size_t n = 300007;
+  Array<long> z(n);
+  for (size_t i = 0; i < n; i++) {
+    z[i] = (i * 7919) % 1000;
+  }
+  auto incl = inclusive_scan(z + 1, 4);
+  auto excl = exclusive_scan(z, 3);
+  auto win = moving_sum(z, 100, 4);
+  long running = 0;
+  for (size_t i = 0; i < n; i++) {
+    assert(excl[i] == running);
+    running += z[i];
+    assert(incl[i] == running + static_cast<long>(i) + 1);
+    if (i % 997 == 0 || i < 200) {
+      long window = 0;
+      for (size_t j = i < 99 ? 0 : i - 99; j <= i; j++) {
+        window += z[j];
+      }
+      assert(win[i] == window);
+    }
+  }
+}
+
+void TestFixedArray() {
+  std::cout << "==========Test Fixed Array==========\n";
+  FixedArray<float, 3> a(array<float, 3>{1, 2, 3});
+  FixedArray<float, 3> b(array<float, 3>{4, 5, 6});
+  FixedArray<float, 3> c;
+  c.print();
+  c = a * 2 + b;
+  c.print();
+  assert(c[0] == 6 && c[1] == 9 && c[2] == 12);
+  assert(sum(a * b) == 32);
+
+  // the size of an expression over fixed-size arrays is a constant
+  auto e = where(a < b, a, b) * 2.0f + 1.0f;
+  static_assert(A_StaticSize<remove_cvref_t<decltype(e.rep())>>::value == 3);
+  assert(e.size() == 3);
+
+  // fixed-size and runtime-sized arrays mix
+  Array<float> d(3);
+  d = c + a;
+  assert(d[2] == 15);
+  c = d * a;
+  assert(c[1] == 22);
+}
+
+void TestSparse() {
+  std::cout << "==========Test Sparse==========\n";
+  Array<double, SparseArray<double>> s(10), t(10);
+  s.rep().push_back(1, 2.0);
+  s.rep().push_back(4, 3.0);
+  s.rep().push_back(9, 1.0);
+  t.rep().push_back(4, 5.0);
+  t.rep().push_back(7, -1.0);
+  s.print();
+  Array<double> d(10);
+  for (size_t i = 0; i < d.size(); i++) {
+    d[i] = i;
+  }
+
+  // sparse times dense or scalar visits only the nonzeros of s
+  assert(sum(s * d) == 2 + 12 + 9);
+  assert(sum(d * s * 2.0) == 46);
+  Array<double, SparseArray<double>> u(10);
+  u = s * d;
+  assert(u.rep().nonzeros() == 3 && u[4] == 12 && u[5] == 0);
+
+  // sparse + sparse and sparse * sparse merge the index lists
+  u = s + t * 2.0;
+  u.print();
+  assert(u.rep().nonzeros() == 4 && u[4] == 13 && u[7] == -2);
+  u = s * t;
+  assert(u.rep().nonzeros() == 1 && u[4] == 15);
+
+  // into dense storage, and dense expressions into sparse storage
+  d = s + t;
+  assert(d[0] == 0 && d[4] == 8 && d[7] == -1 && d[9] == 1);
+  u = d * 1.0;
+  assert(u.rep().nonzeros() == 4 && sum(u) == 10);
+  u = u * 3.0;
+  assert(sum(u) == 30);
+}
+
+void TestStreamingStores() {
+  std::cout << "==========Test Streaming Stores==========\n";
+  // Array assignment streams only results larger than the last-level
+  // cache; exercise the streaming loop directly on a small, unaligned range
+  Array<double> x(101), y(101), z(101);
+  for (size_t i = 0; i < x.size(); i++) {
+    x[i] = i;
+  }
+#ifdef __SSE2__
+  A_stream(z.rep().data() + 1, (x * 2.0 + 1.0).rep(), 100);
+  for (size_t i = 0; i < 100; i++) {
+    assert(z[i + 1] == 2.0 * i + 1);
+  }
+#endif
+  std::cout << "stream threshold: " << A_stream_threshold() << " bytes\n";
+
+  // a destination that the expression reads is never streamed
+  assert(A_reads((x * 2.0 + y).rep(), y.rep().data()));
+  assert(!A_reads((x * 2.0 + y).rep(), z.rep().data()));
+}
+
+void TestGenerators() {
+  std::cout << "==========Test Generators==========\n";
+  Array<double> x(5);
+  x = iota(5, 1.0) * 2.0;
+  x.print();
+  assert(x[0] == 2 && x[4] == 10);
+  x = linspace(0.0, 1.0, 5);
+  x.print();
+  assert(x[1] == 0.25 && x[4] == 1.0);
+
+  // known-answer tests of Philox4x32-10
+  array<uint32_t, 4> r = A_philox(0, 0);
+  assert(r[0] == 0x6627e8d5 && r[1] == 0xe169c58d && r[2] == 0xbc57ac4c &&
+         r[3] == 0x9b00dbd8);
+
+  // random values depend only on the seed and the index
+  auto u = uniform(1000, 42);
+  assert(u[7] == uniform(10, 42)[7] && u[7] != uniform(10, 43)[7]);
+
+  // Monte Carlo estimate of pi, generated inside the summation loop
+  size_t n = 1 << 20;
+  auto a = uniform(n, 1);
+  auto b = uniform(n, 2);
+  double pi = 4 * sum(where(a * a + b * b < 1.0, 1.0, 0.0)) / n;
+  std::cout << "pi ~ " << pi << '\n';
+  assert(std::abs(pi - 3.14159) < 0.01);
+
+  auto z = normal<float>(n, 3);
+  double mean = sum(z) / n;
+  double var = sum(z * z) / n - mean * mean;
+  std::cout << "normal: mean " << mean << ", variance " << var << '\n';
+  assert(std::abs(mean) < 0.01 && std::abs(var - 1) < 0.01);
+}
+
 int main() {
   TestAddition();
   TestMultiplication();
+  TestScalarLifetime();
+  TestViews();
+  TestTensor();
+  TestMatMul();
+  TestOptimize();
+  TestMixedPrecision();
+  TestMMapArray();
+  TestEvaluateChunked();
+  TestSum();
+  TestWhere();
+  TestScan();
+  TestFixedArray();
+  TestSparse();
+  TestStreamingStores();
+  TestGenerators();
 
   return 0;
 }
\ No newline at end of file
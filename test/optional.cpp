@@ -0,0 +1,177 @@
+#include "optional.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace stl;
+
+void TestConstruction() {
+  std::cout << "==========TEST CONSTRUCTION==========\n";
+  optional<int> empty;
+  assert(!empty && empty == nullopt && empty.value_or(3) == 3);
+
+  optional<int> i(5);
+  assert(i.has_value() && *i == 5 && i.value() == 5);
+  optional<std::string> s(in_place, 3, 'x');
+  assert(*s == "xxx" && s->size() == 3);
+  auto made = make_optional<std::string>("text");
+  assert(made.value() == "text");
+
+  auto copy = s;
+  assert(copy == s);
+  auto moved = stl::move(copy);
+  assert(*moved == "xxx");
+
+  // explicit unless the value converts implicitly, and never from another
+  // optional
+  static_assert(is_convertible_v<const char*, optional<std::string>>);
+  static_assert(is_constructible_v<optional<std::vector<int>>, int>);
+  static_assert(!is_convertible_v<int, optional<std::vector<int>>>);
+  static_assert(!is_constructible_v<optional<bool>, optional<int>>);
+  static_assert(!is_assignable_v<optional<bool>&, optional<int>>);
+
+  bool thrown = false;
+  try {
+    empty.value();
+  } catch (const bad_optional_access&) {
+    thrown = true;
+  }
+  assert(thrown);
+}
+
+void TestAssignment() {
+  std::cout << "==========TEST ASSIGNMENT==========\n";
+  optional<std::string> s;
+  s = "a long string, not stored inline";
+  assert(s.has_value());
+  optional<std::string> t("text");
+  s = t;
+  assert(s == t);
+  s = nullopt;
+  assert(!s.has_value() && !(s == t));
+  std::string& e = s.emplace(2, 'y');
+  assert(e == "yy" && *s == "yy");
+  s.reset();
+  assert(!s);
+}
+
+// a slot in a table, where index -1 never names an entry
+struct slot {
+  int index;
+  int generation;
+};
+
+template <>
+struct stl::optional_sentinel<slot> {
+  static constexpr bool enabled = true;
+
+  static void make_empty(void* storage) noexcept {
+    int index = -1;
+    std::memcpy(storage, &index, sizeof(index));
+  }
+
+  static bool is_empty(const void* storage) noexcept {
+    int index;
+    std::memcpy(&index, storage, sizeof(index));
+    return index == -1;
+  }
+};
+
+// a slot whose constructor checks the index after storing it
+struct checked_slot {
+  checked_slot(int i) : index(i) {
+    if (index > 100) {
+      throw index;
+    }
+  }
+
+  int index;
+};
+
+template <>
+struct stl::optional_sentinel<checked_slot> : stl::optional_sentinel<slot> {};
+
+void TestSentinel() {
+  std::cout << "==========TEST SENTINEL==========\n";
+  // no flag for types with a spare pattern
+  static_assert(sizeof(optional<int*>) == sizeof(int*));
+  static_assert(sizeof(optional<unique_ptr<int>>) == sizeof(int*));
+  static_assert(sizeof(optional<slot>) == sizeof(slot));
+  // a flag, padded to the alignment of T, for the others
+  static_assert(sizeof(optional<double>) == 2 * sizeof(double));
+  static_assert(is_trivially_copyable_v<optional<int*>>);
+
+  // every pattern of these is a pointer someone uses: MAP_FAILED and SIG_ERR
+  // are all bits set
+  static_assert(sizeof(optional<char*>) > sizeof(char*));
+  static_assert(sizeof(optional<void*>) > sizeof(void*));
+  static_assert(sizeof(optional<void (*)(int)>) > sizeof(void (*)(int)));
+  optional<void*> failed(reinterpret_cast<void*>(~uintptr_t(0)));
+  assert(failed.has_value());
+
+  // a null pointer is a value, not the empty state
+  optional<int*> p(nullptr);
+  assert(p.has_value() && *p == nullptr);
+  p.reset();
+  assert(!p.has_value());
+
+  optional<slot> found(slot{4, 1});
+  assert(found && found->index == 4);
+  found = nullopt;
+  assert(!found);
+
+  // a constructor that throws after writing over the sentinel leaves the
+  // optional empty
+  optional<checked_slot> checked;
+  static_assert(sizeof(checked) == sizeof(checked_slot));
+  try {
+    checked.emplace(200);
+  } catch (int) {
+  }
+  assert(!checked.has_value());
+  checked.emplace(5);
+  assert(checked->index == 5);
+}
+
+void TestOwnership() {
+  std::cout << "==========TEST OWNERSHIP==========\n";
+  optional<unique_ptr<int>> owner;
+  assert(!owner);
+  owner = make_unique<int>(7);
+  assert(owner && **owner == 7);
+
+  // a moved-from optional still holds the unique_ptr, which owns nothing
+  optional<unique_ptr<int>> taken = stl::move(owner);
+  assert(**taken == 7 && owner.has_value() && owner->get() == nullptr);
+  taken.emplace(new int(8));
+  assert(**taken == 8);
+  taken.reset();
+  assert(!taken);
+
+  // move only, and moved rather than copied when a vector reallocates
+  static_assert(!is_copy_constructible_v<optional<unique_ptr<int>>>);
+  static_assert(!is_copy_assignable_v<optional<unique_ptr<int>>>);
+  static_assert(is_nothrow_move_constructible_v<optional<unique_ptr<int>>>);
+  std::vector<optional<unique_ptr<int>>> cache;
+  for (int i = 0; i < 100; i++) {
+    if (i % 3 == 0) {
+      cache.push_back(nullopt);
+    } else {
+      cache.push_back(make_unique<int>(i));
+    }
+  }
+  for (int i = 0; i < 100; i++) {
+    assert(cache[i].has_value() == (i % 3 != 0));
+    assert(i % 3 == 0 || **cache[i] == i);
+  }
+}
+
+int main() {
+  TestConstruction();
+  TestAssignment();
+  TestSentinel();
+  TestOwnership();
+
+  return 0;
+}
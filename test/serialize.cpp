@@ -0,0 +1,135 @@
+#include "serialize.h"
+
+#include <iostream>
+
+using namespace stl;
+
+void TestRoundTrip() {
+  std::cout << "==========TEST ROUND TRIP==========\n";
+  binary_writer w;
+  w.write(42);
+  w.write(array<short, 3>{1, 2, 3});
+  vector<double> samples;
+  for (int i = 0; i < 100; i++) {
+    samples.push_back(i * 0.5);
+  }
+  w.write(samples);
+  // a tuple without padding is one memcpy; one with padding or holding a
+  // vector is encoded element by element
+  w.write(make_tuple(1, 2));
+  w.write(make_tuple('a', 2.5, 7));
+  tuple<int, vector<double>, char> record(3, samples, 'z');
+  w.write(record);
+  std::cout << w.buffer().size() << " bytes\n";
+
+  binary_reader r(w.buffer());
+  assert(r.read<int>() == 42);
+  auto a = r.read<array<short, 3>>();
+  assert(a[0] == 1 && a[2] == 3);
+  auto v = r.read<vector<double>>();
+  assert(v.size() == 100 && v[99] == 49.5);
+  assert((r.read<tuple<int, int>>() == make_tuple(1, 2)));
+  assert((r.read<tuple<char, double, int>>() == make_tuple('a', 2.5, 7)));
+  auto t = r.read<tuple<int, vector<double>, char>>();
+  assert(get<0>(t) == 3 && get<1>(t).size() == 100 && get<2>(t) == 'z');
+  assert(r.remaining() == 0);
+}
+
+void TestPadding() {
+  std::cout << "==========TEST PADDING==========\n";
+  static_assert(serial_bulk_v<tuple<int, int>>);
+  static_assert(serial_bulk_v<array<double, 4>>);
+  static_assert(!serial_bulk_v<tuple<char, double, int>>);
+  static_assert(!serial_bulk_v<array<tuple<char, int>, 2>>);
+
+  // the padding of the tuple is not written, so the encoding of a value does
+  // not depend on whatever the padding bytes hold
+  tuple<char, double, int> t1('a', 2.5, 7);
+  tuple<char, double, int> t2;
+  std::memset(static_cast<void*>(&t2), 0xff, sizeof(t2));
+  t2 = t1;
+  binary_writer w1;
+  binary_writer w2;
+  w1.write(t1);
+  w2.write(t2);
+  assert(w1.buffer().size() == sizeof(char) + sizeof(double) + sizeof(int));
+  assert(std::memcmp(w1.buffer().data(), w2.buffer().data(),
+                     w1.buffer().size()) == 0);
+
+  binary_writer w3;
+  w3.write(array<tuple<char, int>, 2>{make_tuple('x', 1), make_tuple('y', 2)});
+  assert(w3.buffer().size() == 2 * (sizeof(char) + sizeof(int)));
+  binary_reader r(w3.buffer());
+  auto a = r.read<array<tuple<char, int>, 2>>();
+  assert(get<0>(a[1]) == 'y' && get<1>(a[1]) == 2 && r.remaining() == 0);
+}
+
+void TestView() {
+  std::cout << "==========TEST VIEW==========\n";
+  binary_writer w;
+  vector<int> ids;
+  for (int i = 0; i < 10; i++) {
+    ids.push_back(i * i);
+  }
+  w.write('x');  // the elements of ids are padded to alignof(int)
+  w.write(tuple<vector<int>, long>(ids, 5));
+
+  binary_reader r(w.buffer());
+  assert(r.view<char>() == 'x');
+  auto view = r.view<tuple<vector<int>, long>>();
+  static_assert(is_same_v<decltype(view), tuple<std::span<const int>, long>>);
+
+  // the span points into the buffer instead of a copy
+  std::span<const int> s = get<0>(view);
+  assert(s.size() == 10 && s[9] == 81);
+  assert(reinterpret_cast<const unsigned char*>(s.data()) >=
+             w.buffer().data() &&
+         reinterpret_cast<const unsigned char*>(s.data() + s.size()) <=
+             w.buffer().data() + w.buffer().size());
+  assert(get<1>(view) == 5);
+}
+
+void TestTruncated() {
+  std::cout << "==========TEST TRUNCATED==========\n";
+  binary_writer w;
+  vector<double> v(3, 1.0);
+  w.write(v);
+
+  // a buffer that ends early, or a corrupt size, is an error
+  binary_reader r(w.buffer().data(), w.buffer().size() - 1);
+  bool thrown = false;
+  try {
+    r.read<vector<double>>();
+  } catch (const std::out_of_range&) {
+    thrown = true;
+  }
+  assert(thrown);
+
+  // a size so large that the byte count wraps around
+  binary_writer corrupt;
+  corrupt.write((uint64_t(1) << 62) + 1);
+  corrupt.write(0L);
+  auto throws_out_of_range = [&corrupt](auto read) {
+    binary_reader r(corrupt.buffer());
+    try {
+      read(r);
+    } catch (const std::out_of_range&) {
+      return true;
+    }
+    return false;
+  };
+  assert(throws_out_of_range([](binary_reader& r) { r.read<vector<int>>(); }));
+  assert(throws_out_of_range([](binary_reader& r) { r.view<vector<int>>(); }));
+  // elements that are not trivially copyable are not allocated for either
+  assert(throws_out_of_range(
+      [](binary_reader& r) { r.read<vector<vector<int>>>(); }));
+}
+
+int main() {
+  TestRoundTrip();
+  TestPadding();
+  TestView();
+  TestTruncated();
+
+  return 0;
+}
@@ -0,0 +1,124 @@
+#include "soa_vector.h"
+
+#include <iostream>
+
+using namespace stl;
+
+using particle = tuple<int, double, double, char>;
+
+void TestPushBack() {
+  std::cout << "==========TEST PUSH BACK==========\n";
+  soa_vector<particle> v;
+  assert(v.empty());
+  v.push_back(particle(1, 0.5, 1.5, 'a'));
+  v.emplace_back(2, 2.5, 3.5, 'b');
+  v.push_back(make_tuple(3, 4.5, 5.5, 'c'));
+  assert(v.size() == 3);
+
+  // a row reads and writes the fields in the columns
+  assert(get<0>(v[1]) == 2 && get<3>(v[1]) == 'b');
+  get<1>(v[1]) = 9.0;
+  assert(v.column<1>()[1] == 9.0);
+  particle p = v[2];
+  assert(p == make_tuple(3, 4.5, 5.5, 'c'));
+  v[0] = v[2];
+  assert(get<0>(v[0]) == 3 && get<3>(v[0]) == 'c');
+  std::cout << particle(v[1]) << '\n';
+
+  v.pop_back();
+  assert(v.size() == 2);
+  v.clear();
+  assert(v.empty());
+}
+
+void TestColumns() {
+  std::cout << "==========TEST COLUMNS==========\n";
+  static_assert(is_same_v<soa_vector<particle>::field_type<3>, char>);
+  soa_vector<particle> v(100);
+  for (int i = 0; i < 100; i++) {
+    v[i] = particle(i, 1.0, 0.0, 'x');
+  }
+
+  // a scan over two fields reads two contiguous columns
+  auto ids = v.column<0>();
+  auto masses = v.column<1>();
+  assert(ids.size() == 100 && masses.data() + 100 == &get<1>(v[99]) + 1);
+  double sum = 0;
+  for (size_t i = 0; i < ids.size(); i++) {
+    sum += ids[i] * masses[i];
+  }
+  assert(sum == 4950);
+
+  const auto& cv = v;
+  static_assert(is_same_v<decltype(cv.column<2>()), std::span<const double>>);
+  static_assert(is_same_v<decltype(get<2>(cv[0])), const double&>);
+  int rows = 0;
+  for (auto row : cv) {
+    assert(get<0>(row) == rows++);
+  }
+  assert(rows == 100);
+}
+
+// a field whose construction throws while `fail` is set
+struct fragile {
+  static inline bool fail = false;
+
+  fragile(int v = 0) : value(v) { check(); }
+  fragile(const fragile& other) : value(other.value) { check(); }
+  fragile& operator=(const fragile& other) {
+    check();
+    value = other.value;
+    return *this;
+  }
+
+  static void check() {
+    if (fail) {
+      throw 1;
+    }
+  }
+
+  int value;
+};
+
+void TestExceptionSafety() {
+  std::cout << "==========TEST EXCEPTION SAFETY==========\n";
+  soa_vector<tuple<int, fragile>> v;
+  v.emplace_back(1, 10);
+  tuple<int, fragile> record(2, 20);
+
+  // the int column is extended before the fragile one throws, and is shrunk
+  // back
+  fragile::fail = true;
+  int thrown = 0;
+  try {
+    v.emplace_back(3, 30);
+  } catch (int) {
+    thrown++;
+  }
+  try {
+    v.push_back(record);
+  } catch (int) {
+    thrown++;
+  }
+  try {
+    v.resize(10);
+  } catch (int) {
+    thrown++;
+  }
+  fragile::fail = false;
+  assert(thrown == 3 && v.size() == 1);
+
+  // the columns still line up
+  v.push_back(record);
+  assert(v.size() == 2);
+  assert(get<0>(v[1]) == 2 && get<1>(v[1]).value == 20);
+  assert(v.column<0>()[0] == 1 && v.column<1>()[0].value == 10);
+}
+
+int main() {
+  TestPushBack();
+  TestColumns();
+  TestExceptionSafety();
+
+  return 0;
+}
@@ -1,5 +1,6 @@
 #include "tuple.h"
 #include <iostream>
+#include <sstream>
 
 using namespace stl;
 
@@ -22,9 +23,192 @@ void TestPrintTuple() {
   std::cout << empty << '\n';
 }
 
+void TestFlatLayout() {
+  // elements of equal types are distinct leaves
+  tuple<int, int, int> t(1, 2, 3);
+  assert(get<0>(t) == 1 && get<1>(t) == 2 && get<2>(t) == 3);
+
+  // conversion and comparison element by element
+  tuple<long, double, long> u(t);
+  assert(u == t);
+  assert(!(u == make_tuple(1, 2, 4)));
+  assert(tuple<>() == tuple<>());
+
+  // a one-element tuple is copied, not used to initialize its element
+  tuple<tuple<int>> nested(tuple<int>(5));
+  tuple<tuple<int>> copy(nested);
+  assert(get<0>(get<0>(copy)) == 5);
+
+  // access to the last of many elements takes no recursion
+  auto wide = make_tuple(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+                         15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27,
+                         28, 29);
+  assert(get<29>(wide) == 29);
+  std::cout << wide << '\n';
+}
+
+// counts the copies made of it
+struct copy_counter {
+  static inline int copies = 0;
+
+  copy_counter() = default;
+  copy_counter(const copy_counter&) { copies++; }
+  copy_counter(copy_counter&&) = default;
+  copy_counter& operator=(const copy_counter&) {
+    copies++;
+    return *this;
+  }
+};
+
+void TestGet() {
+  std::string text = "a long string, not stored inline";
+  tuple<int, std::string, copy_counter> t(1, text, copy_counter());
+  int copies = copy_counter::copies;
+
+  // access by reference: no copies, and writes go to the element
+  get<2>(t);
+  const auto& ct = t;
+  get<2>(ct);
+  get<copy_counter>(ct);
+  assert(copy_counter::copies == copies);
+  get<0>(t) = 2;
+  get<int>(t) += 1;
+  assert(get<0>(ct) == 3);
+  static_assert(is_same_v<decltype(get<1>(ct)), const std::string&>);
+  static_assert(is_same_v<decltype(get<1>(std::move(t))), std::string&&>);
+
+  // elements of an rvalue tuple are moved out
+  std::string s = get<1>(std::move(t));
+  assert(s == text && get<1>(t).empty());
+  [[maybe_unused]] copy_counter c = get<copy_counter>(std::move(t));
+  assert(copy_counter::copies == copies);
+}
+
+// stateless, like std::allocator or std::default_delete
+struct empty_tag {
+  int id() const { return 7; }
+  bool operator==(const empty_tag&) const = default;
+};
+
+struct final_tag final {
+  bool operator==(const final_tag&) const = default;
+};
+
+void TestEmptyElements() {
+  // empty elements take no space
+  static_assert(sizeof(tuple<int, empty_tag>) == sizeof(int));
+  static_assert(sizeof(tuple<empty_tag, double*>) == sizeof(double*));
+  static_assert(sizeof(tuple<empty_tag>) == 1);
+  tuple<empty_tag, int> t(empty_tag(), 3);
+  assert(get<0>(t).id() == 7 && get<1>(t) == 3);
+  assert(get<empty_tag>(t).id() == 7);
+
+  // a final class takes no space either
+  tuple<int, final_tag> f(1, final_tag());
+  static_assert(sizeof(f) == sizeof(int));
+  assert(get<0>(f) == 1);
+
+  // the leaves of a nested tuple of empty elements stay inside it
+  tuple<tuple<empty_tag, final_tag>, int> nested;
+  get<1>(nested) = 4;
+  static_assert(is_same_v<tuple_element_t<1, decltype(nested)>, int>);
+  assert(get<0>(get<0>(nested)).id() == 7 && get<1>(nested) == 4);
+  assert(nested == nested);
+}
+
+void TestPackedTuple() {
+  // (char, pad 7, double, char, pad 3, int) against (double, int, char, char)
+  static_assert(sizeof(tuple<char, double, char, int>) == 24);
+  static_assert(sizeof(packed_tuple<char, double, char, int>) == 16);
+  static_assert(sizeof(packed_tuple<char, empty_tag, long>) == 16);
+
+  // elements keep their indices
+  std::string text = "a long string, not stored inline";
+  packed_tuple<char, std::string, short, double> p('a', text, 2, 0.5);
+  assert(get<0>(p) == 'a' && get<1>(p) == text);
+  assert(get<2>(p) == 2 && get<3>(p) == 0.5);
+  get<short>(p) = 3;
+  assert(get<2>(p) == 3);
+  static_assert(is_same_v<decltype(get<1>(std::move(p))), std::string&&>);
+
+  // the elements are laid out by decreasing alignment
+  auto base = reinterpret_cast<const char*>(&p);
+  assert(reinterpret_cast<const char*>(&get<3>(p)) - base <
+         reinterpret_cast<const char*>(&get<2>(p)) - base);
+  assert(reinterpret_cast<const char*>(&get<2>(p)) - base <
+         reinterpret_cast<const char*>(&get<0>(p)) - base);
+
+  packed_tuple<int, std::string> d;
+  assert(get<0>(d) == 0 && get<1>(d).empty());
+}
+
+// std::string brings the std versions of these functions into overload
+// resolution by argument-dependent lookup, so the calls are qualified
+void TestApply() {
+  auto t = stl::make_tuple(1, 2.5, std::string("three"));
+  static_assert(tuple_size_v<decltype(t)> == 3);
+  static_assert(is_same_v<tuple_element_t<1, decltype(t)>, double>);
+  auto describe = [](int i, double d, const std::string& s) {
+    return std::to_string(i) + " " + std::to_string(d) + " " + s;
+  };
+  assert(stl::apply(describe, t) == "1 2.500000 three");
+
+  // each element in order
+  std::string visited;
+  stl::tuple_for_each(
+      [&](const auto& e) { visited += (std::ostringstream() << e).str(); }, t);
+  assert(visited == "12.5three");
+
+  // zipped: the elements at one index of several tuples together
+  tuple<int, double> x(1, 2.0), y(10, 20.0);
+  stl::tuple_for_each([](auto& a, auto b) { a += b; }, x, y);
+  assert(x == stl::make_tuple(11, 22.0));
+  auto products =
+      stl::tuple_transform([](auto a, auto b) { return a * b; }, x, y);
+  assert(products == stl::make_tuple(110, 440.0));
+  auto sizes = stl::tuple_transform([](const auto& e) { return sizeof(e); }, t);
+  static_assert(is_same_v<decltype(sizes), tuple<size_t, size_t, size_t>>);
+
+  // elements of an rvalue tuple are moved into f
+  std::string moved;
+  stl::tuple_for_each([&](auto&& e) { moved = std::move(e); },
+                      stl::make_tuple(std::string("moved")));
+  assert(moved == "moved");
+
+  packed_tuple<char, double> p('a', 1.5);
+  assert(stl::apply([](char c, double d) { return c + d; }, p) == 'a' + 1.5);
+}
+
+void TestTupleCat() {
+  std::string text = "a long string, not stored inline";
+  tuple<int, std::string> a(1, text);
+  auto c = stl::tuple_cat(a, stl::make_tuple(2.5), tuple<>(),
+                          stl::make_tuple('x', 3));
+  static_assert(
+      is_same_v<decltype(c), tuple<int, std::string, double, char, int>>);
+  assert(c == stl::make_tuple(1, text, 2.5, 'x', 3));
+  assert(get<1>(a) == text);
+
+  // elements of rvalue arguments are moved, and references stay references
+  int n = 4;
+  auto m = stl::tuple_cat(std::move(a), tuple<int&>(n));
+  static_assert(is_same_v<decltype(m), tuple<int, std::string, int&>>);
+  assert(get<1>(m) == text && get<1>(a).empty());
+  get<2>(m) = 5;
+  assert(n == 5);
+
+  static_assert(is_same_v<decltype(stl::tuple_cat()), tuple<>>);
+}
+
 int main() {
   TestConstruction();
   TestPrintTuple();
+  TestFlatLayout();
+  TestGet();
+  TestEmptyElements();
+  TestPackedTuple();
+  TestApply();
+  TestTupleCat();
   
   return 0;
 }
\ No newline at end of file
@@ -549,6 +549,22 @@ void TestIsAggregate() {
   static_assert(!is_aggregate_v<B>);
 }
 
+// has_unique_object_representations
+void TestHasUniqueObjectRepresentations() {
+  struct A {
+    int x, y;
+  };
+  struct B {
+    char c;
+    int x;  // preceded by padding
+  };
+
+  using stl::has_unique_object_representations_v;
+  static_assert(has_unique_object_representations_v<A>);
+  static_assert(!has_unique_object_representations_v<B>);
+  static_assert(!has_unique_object_representations_v<float>);
+}
+
 // is_signed
 void TestIsSigned() {
   class A {};
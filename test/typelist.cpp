@@ -6,6 +6,13 @@ using namespace stl;
 
 using signed_integral_types = typelist<signed char, short, int, long long>;
 
+// longer than the eight elements that reverse and pop_back move at a time
+using ten_types = typelist<char[1], char[2], char[3], char[4], char[5],
+                           char[6], char[7], char[8], char[9], char[10]>;
+
+template <typename... Types>
+struct pack {};
+
 // is_empty
 void TestIsEmpty() {
   static_assert(is_list_empty_v<typelist<>>);
@@ -36,6 +43,9 @@ void TestNthElement() {
       is_same_v<nth_element_t<signed_integral_types, 0>, signed char>);
   static_assert(is_same_v<nth_element_t<signed_integral_types, 2>, int>);
   static_assert(is_same_v<nth_element_t<signed_integral_types, 3>, long long>);
+
+  // any class template of types is a list
+  static_assert(is_same_v<nth_element_t<pack<int, char>, 1>, char>);
 }
 
 // largest_type
@@ -55,12 +65,21 @@ void TestPushBack() {
 void TestReverse() {
   using result = typelist<long long, int, short, signed char>;
   static_assert(is_same_v<result, reverse_t<signed_integral_types>>);
+  static_assert(is_same_v<reverse_t<typelist<>>, typelist<>>);
+
+  static_assert(is_same_v<reverse_t<reverse_t<ten_types>>, ten_types>);
+  static_assert(is_same_v<nth_element_t<reverse_t<ten_types>, 0>, char[10]>);
+  static_assert(is_same_v<nth_element_t<reverse_t<ten_types>, 9>, char[1]>);
+  static_assert(is_same_v<reverse_t<pack<int, char>>, pack<char, int>>);
 }
 
 // pop_back
 void TestPopBack() {
   using result = typelist<signed char, short, int>;
   static_assert(is_same_v<result, pop_back_t<signed_integral_types>>);
+  static_assert(is_same_v<pop_back_t<typelist<int>>, typelist<>>);
+  static_assert(
+      is_same_v<push_back_t<pop_back_t<ten_types>, char[10]>, ten_types>);
 }
 
 // transform
@@ -79,6 +98,55 @@ void TestAccumulate() {
   using result_push_back =
       accumulate_t<signed_integral_types, push_back_t, typelist<>>;
   static_assert(is_same_v<result_push_back, signed_integral_types>);
+  static_assert(is_same_v<accumulate_t<typelist<>, push_back_t, int>, int>);
+}
+
+// contains
+void TestContains() {
+  static_assert(contains_v<signed_integral_types, int>);
+  static_assert(!contains_v<signed_integral_types, unsigned>);
+  static_assert(!contains_v<typelist<>, int>);
+}
+
+// index_of
+void TestIndexOf() {
+  static_assert(index_of_v<signed_integral_types, signed char> == 0);
+  static_assert(index_of_v<signed_integral_types, long long> == 3);
+  static_assert(index_of_v<typelist<int, char, int>, int> == 0);
+}
+
+// filter
+template <typename T>
+struct wider_than_short : bool_constant<(sizeof(T) > sizeof(short))> {};
+
+void TestFilter() {
+  static_assert(is_same_v<filter_t<signed_integral_types, wider_than_short>,
+                          typelist<int, long long>>);
+  static_assert(is_same_v<filter_t<ten_types, is_pointer>, typelist<>>);
+  static_assert(is_same_v<filter_t<typelist<>, is_pointer>, typelist<>>);
+}
+
+// unique
+void TestUnique() {
+  using list = typelist<int, char, int, short, char, int>;
+  static_assert(is_same_v<unique_t<list>, typelist<int, char, short>>);
+  static_assert(is_same_v<unique_t<ten_types>, ten_types>);
+  static_assert(is_same_v<unique_t<typelist<>>, typelist<>>);
+}
+
+// sort
+void TestSort() {
+  using list = typelist<short, long long, signed char, int>;
+  static_assert(is_same_v<sort_t<list, greater_size>,
+                          reverse_t<signed_integral_types>>);
+  static_assert(is_same_v<sort_t<reverse_t<ten_types>, greater_size>,
+                          reverse_t<ten_types>>);
+  static_assert(is_same_v<sort_t<typelist<>, greater_size>, typelist<>>);
+
+  // stable: elements of equal alignment keep their order
+  using fields = typelist<char, double, int, char[3], long, float>;
+  static_assert(is_same_v<sort_t<fields, greater_alignment>,
+                          typelist<double, long, int, float, char, char[3]>>);
 }
 
 int main() { return 0; }
@@ -0,0 +1,194 @@
+#include "variant.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "memory.h"
+
+using namespace stl;
+
+void TestConstruction() {
+  std::cout << "==========TEST CONSTRUCTION==========\n";
+  variant<int, double, std::string> v;
+  assert(v.index() == 0 && get<0>(v) == 0);
+
+  // the converting constructor picks the alternative the value initializes
+  variant<int, double, std::string> d(2.5);
+  assert(d.index() == 1 && get<double>(d) == 2.5);
+  variant<int, double, std::string> s("text");
+  assert(holds_alternative<std::string>(s) && get<2>(s) == "text");
+
+  // a pointer is not narrowed to bool
+  variant<bool, std::string> b("text");
+  assert(holds_alternative<std::string>(b));
+
+  variant<int, std::string> in_place(in_place_index<1>, 3, 'x');
+  assert(get<1>(in_place) == "xxx");
+  variant<int, std::string> by_type(in_place_type<std::string>, "abc");
+  assert(get<std::string>(by_type) == "abc");
+
+  // copies and moves hold the same alternative
+  auto copy = s;
+  assert(copy == s);
+  auto moved = stl::move(copy);
+  assert(get<2>(moved) == "text");
+
+  // a value no alternative takes leaves the constructor out of overload
+  // resolution
+  static_assert(
+      !is_constructible_v<variant<int, std::string>, std::vector<int>>);
+  static_assert(
+      !is_assignable_v<variant<int, std::string>&, std::vector<int>>);
+}
+
+void TestAssignment() {
+  std::cout << "==========TEST ASSIGNMENT==========\n";
+  variant<int, std::string> v(1);
+  v = std::string("a long string, not stored inline");
+  assert(v.index() == 1);
+  v = 5;
+  assert(get<int>(v) == 5);
+  get<int>(v) += 1;
+  assert(get<0>(v) == 6);
+
+  variant<int, std::string> w("text");
+  v = w;
+  assert(v == w);
+  v.emplace<0>(7);
+  assert(!(v == w) && get<0>(v) == 7);
+  std::string& e = v.emplace<std::string>(2, 'y');
+  assert(e == "yy" && get<1>(v) == "yy");
+
+  bool thrown = false;
+  try {
+    get<int>(v);
+  } catch (const bad_variant_access&) {
+    thrown = true;
+  }
+  assert(thrown);
+  assert(get_if<int>(&v) == nullptr && *get_if<1>(&v) == "yy");
+}
+
+// throws from its constructor, which leaves a variant valueless
+struct throws_on_construction {
+  throws_on_construction(int) { throw 1; }
+};
+
+void TestValueless() {
+  std::cout << "==========TEST VALUELESS==========\n";
+  variant<std::string, throws_on_construction> v("text");
+  try {
+    v.emplace<1>(0);
+  } catch (int) {
+  }
+  assert(v.valueless_by_exception() && v.index() == variant_npos);
+  bool thrown = false;
+  try {
+    visit([](auto&) {}, v);
+  } catch (const bad_variant_access&) {
+    thrown = true;
+  }
+  assert(thrown);
+  v = std::string("again");
+  assert(get<0>(v) == "again");
+}
+
+void TestCompactLayout() {
+  std::cout << "==========TEST COMPACT LAYOUT==========\n";
+  // a one-byte index after storage for the largest alternative
+  static_assert(sizeof(variant<char, short>) == 4);
+  static_assert(sizeof(variant<int, float, char>) == 8);
+  static_assert(sizeof(variant<double, char[9]>) == 16);
+  // 255 alternatives leave 255 for the valueless marker
+  static_assert(is_same_v<variant_index_t<255>, unsigned char>);
+  static_assert(is_same_v<variant_index_t<256>, unsigned short>);
+  static_assert(is_same_v<variant_index_t<65535>, unsigned short>);
+  static_assert(is_same_v<variant_index_t<65536>, unsigned>);
+
+  // alternatives copied bitwise make a variant copied bitwise
+  static_assert(is_trivially_copyable_v<variant<int, double, char>>);
+  static_assert(!is_trivially_copyable_v<variant<int, std::string>>);
+}
+
+template <size_t I>
+struct event {
+  int payload = I;
+};
+
+template <size_t... I>
+void visit_many(std::index_sequence<I...>) {
+  // more alternatives than the switch handles: dispatch through the table
+  using many = variant<event<I>...>;
+  int total = 0;
+  for (size_t i = 0; i < sizeof...(I); i++) {
+    many v;
+    ((i == I ? (void)v.template emplace<I>() : (void)0), ...);
+    total += visit([](const auto& e) { return e.payload; }, v);
+  }
+  assert(total == (int(I) + ...));
+}
+
+void TestMoveOnly() {
+  std::cout << "==========TEST MOVE ONLY==========\n";
+  using event = variant<unique_ptr<int>, int>;
+  static_assert(!is_copy_constructible_v<event>);
+  static_assert(!is_copy_assignable_v<event>);
+  static_assert(is_nothrow_move_constructible_v<event>);
+  static_assert(is_nothrow_move_assignable_v<event>);
+
+  // moved rather than copied when the vector reallocates
+  std::vector<event> queue;
+  for (int i = 0; i < 100; i++) {
+    if (i % 2 == 0) {
+      queue.push_back(make_unique<int>(i));
+    } else {
+      queue.push_back(i);
+    }
+  }
+  for (int i = 0; i < 100; i++) {
+    assert(i % 2 == 0 ? *get<0>(queue[i]) == i : get<1>(queue[i]) == i);
+  }
+  queue[0] = stl::move(queue[1]);
+  assert(get<1>(queue[0]) == 1);
+}
+
+void TestVisit() {
+  std::cout << "==========TEST VISIT==========\n";
+  variant<int, double, std::string> v(2.5);
+  auto describe = [](const auto& value) {
+    if constexpr (is_same_v<decay_t<decltype(value)>, std::string>) {
+      return value;
+    } else {
+      return std::to_string(value);
+    }
+  };
+  assert(visit(describe, v) == "2.500000");
+  v = std::string("text");
+  assert(visit(describe, v) == "text");
+
+  // the value of an rvalue variant is visited as an rvalue
+  std::string taken = visit(
+      [](auto&& value) -> std::string {
+        if constexpr (is_same_v<decltype(value), std::string&&>) {
+          return stl::move(value);
+        } else {
+          return "";
+        }
+      },
+      stl::move(v));
+  assert(taken == "text" && get<2>(v).empty());
+
+  visit_many(std::make_index_sequence<20>());
+}
+
+int main() {
+  TestConstruction();
+  TestAssignment();
+  TestValueless();
+  TestCompactLayout();
+  TestMoveOnly();
+  TestVisit();
+
+  return 0;
+}